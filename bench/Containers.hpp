@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <queue>
+#include <span>
+#include <string_view>
+
+#include "AlterHeap.hpp"
+#include "BSTree.hpp"
+#include "RBTree.hpp"
+
+namespace bs::bench
+{
+
+/// @brief Uniform `insert()`, `find()`, `erase()` over every benchmarked container.
+/// Heaps ignore the key on `erase()` and pop the top instead.
+///
+/// Each adapter also declares:
+///   - `NAME`: name used in the reports
+///   - `SUPPORTS_FIND`: whether the `find` phase is meaningful
+///   - `MAX_DEGENERATE_SIZE`: size limit on sorted workloads, which degrade unbalanced trees to a list
+///   - `MONOTONE_ONLY`: whether it only runs the workloads which never insert above the last popped key
+///
+/// Adapters with a batched `find_many(keys, out)` or `find_sorted_batch(keys, out)`
+/// are measured on the `FIND_MANY` or `FIND_SORTED_BATCH` phase as well,
+/// and the ones with `update(key, priority)` on the `UPDATE` phase.
+
+struct BenchItem
+{
+    std::uint64_t priority;
+    std::uint64_t id;
+
+    auto unique_id() const -> std::uint64_t
+    {
+        return id;
+    }
+    bool operator<(const BenchItem& other) const
+    {
+        return priority < other.priority;
+    }
+};
+
+struct BenchItemPriority
+{
+    auto operator()(const BenchItem& item) const -> std::uint64_t
+    {
+        return item.priority;
+    }
+};
+
+class RBTreeAdapter
+{
+public:
+    static constexpr std::string_view NAME = "RBTree";
+    static constexpr bool SUPPORTS_FIND = true;
+    static constexpr std::size_t MAX_DEGENERATE_SIZE = SIZE_MAX;
+    static constexpr bool MONOTONE_ONLY = false;
+
+    void insert(std::uint64_t key)
+    {
+        _tree.insert(key, key);
+    }
+
+    bool find(std::uint64_t key) const
+    {
+        return _tree.find(key) != nullptr;
+    }
+
+    void find_many(std::span<const std::uint64_t> keys, std::span<const std::uint64_t*> out) const
+    {
+        _tree.find_many(keys, out);
+    }
+
+    void find_sorted_batch(std::span<const std::uint64_t> keys, std::span<const std::uint64_t*> out) const
+    {
+        _tree.find_sorted_batch(keys, out);
+    }
+
+    void update(std::uint64_t key, std::uint64_t priority)
+    {
+        _tree.insert_or_assign(key, priority);
+    }
+
+    void erase(std::uint64_t key)
+    {
+        _tree.erase(key);
+    }
+
+private:
+    RBTree<std::uint64_t, std::uint64_t> _tree;
+};
+
+class BSTreeAdapter
+{
+public:
+    static constexpr std::string_view NAME = "BSTree";
+    static constexpr bool SUPPORTS_FIND = true;
+    // `BSTree` recurses once per level, sorted input would overflow the stack
+    static constexpr std::size_t MAX_DEGENERATE_SIZE = 10'000;
+    static constexpr bool MONOTONE_ONLY = false;
+
+    void insert(std::uint64_t key)
+    {
+        _tree.insert(key, key);
+    }
+
+    bool find(std::uint64_t key)
+    {
+        return _tree.find(key) != nullptr;
+    }
+
+    void update(std::uint64_t key, std::uint64_t priority)
+    {
+        _tree.insert_or_assign(key, priority);
+    }
+
+    void erase(std::uint64_t key)
+    {
+        _tree.erase(key);
+    }
+
+private:
+    BSTree<std::uint64_t, std::uint64_t> _tree;
+};
+
+class StdMapAdapter
+{
+public:
+    static constexpr std::string_view NAME = "std::map";
+    static constexpr bool SUPPORTS_FIND = true;
+    static constexpr std::size_t MAX_DEGENERATE_SIZE = SIZE_MAX;
+    static constexpr bool MONOTONE_ONLY = false;
+
+    void insert(std::uint64_t key)
+    {
+        _map.emplace(key, key);
+    }
+
+    bool find(std::uint64_t key) const
+    {
+        return _map.find(key) != _map.cend();
+    }
+
+    void update(std::uint64_t key, std::uint64_t priority)
+    {
+        _map.insert_or_assign(key, priority);
+    }
+
+    void erase(std::uint64_t key)
+    {
+        _map.erase(key);
+    }
+
+private:
+    std::map<std::uint64_t, std::uint64_t> _map;
+};
+
+template <typename Engine>
+constexpr std::string_view HEAP_ENGINE_NAME = "";
+template <>
+constexpr std::string_view HEAP_ENGINE_NAME<DaryHeapEngine<2>> = "AlterBinaryHeap";
+template <>
+constexpr std::string_view HEAP_ENGINE_NAME<DaryHeapEngine<4>> = "AlterDaryHeap4";
+template <>
+constexpr std::string_view HEAP_ENGINE_NAME<DaryHeapEngine<8>> = "AlterDaryHeap8";
+template <>
+constexpr std::string_view HEAP_ENGINE_NAME<PairingHeapEngine> = "AlterPairingHeap";
+template <>
+constexpr std::string_view HEAP_ENGINE_NAME<MinMaxHeapEngine> = "AlterMinMaxHeap";
+template <>
+constexpr std::string_view HEAP_ENGINE_NAME<RadixHeapEngine<BenchItemPriority>> = "AlterRadixHeap";
+
+template <typename Engine>
+class AlterHeapAdapter
+{
+    using Heap = AlterHeap<BenchItem, Engine>;
+
+public:
+    static constexpr std::string_view NAME = HEAP_ENGINE_NAME<Engine>;
+    static constexpr bool SUPPORTS_FIND = true;
+    static constexpr std::size_t MAX_DEGENERATE_SIZE = SIZE_MAX;
+    static constexpr bool MONOTONE_ONLY = Heap::MONOTONE;
+
+    void insert(std::uint64_t key)
+    {
+        _heap.push(BenchItem{.priority = key, .id = key});
+    }
+
+    bool find(std::uint64_t key) const
+    {
+        return _heap.find(key) != _heap.cend();
+    }
+
+    void update(std::uint64_t key, std::uint64_t priority)
+    {
+        _heap.increase_key(key, [priority](BenchItem& item) { item.priority = priority; });
+    }
+
+    void erase([[maybe_unused]] std::uint64_t key)
+    {
+        if (!_heap.empty())
+            _heap.pop();
+    }
+
+private:
+    Heap _heap;
+};
+
+using AlterBinaryHeapAdapter = AlterHeapAdapter<DaryHeapEngine<2>>;
+using AlterDaryHeap4Adapter = AlterHeapAdapter<DaryHeapEngine<4>>;
+using AlterDaryHeap8Adapter = AlterHeapAdapter<DaryHeapEngine<8>>;
+using AlterPairingHeapAdapter = AlterHeapAdapter<PairingHeapEngine>;
+using AlterMinMaxHeapAdapter = AlterHeapAdapter<MinMaxHeapEngine>;
+using AlterRadixHeapAdapter = AlterHeapAdapter<RadixHeapEngine<BenchItemPriority>>;
+
+class PriorityQueueAdapter
+{
+public:
+    static constexpr std::string_view NAME = "std::priority_queue";
+    static constexpr bool SUPPORTS_FIND = false;
+    static constexpr std::size_t MAX_DEGENERATE_SIZE = SIZE_MAX;
+    static constexpr bool MONOTONE_ONLY = false;
+
+    void insert(std::uint64_t key)
+    {
+        _queue.push(key);
+    }
+
+    bool find([[maybe_unused]] std::uint64_t key) const
+    {
+        return false;
+    }
+
+    void erase([[maybe_unused]] std::uint64_t key)
+    {
+        if (!_queue.empty())
+            _queue.pop();
+    }
+
+private:
+    std::priority_queue<std::uint64_t> _queue;
+};
+
+} // namespace bs::bench
@@ -0,0 +1,138 @@
+#include "PerfCounters.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace bs::bench
+{
+
+namespace
+{
+
+constexpr std::string_view COUNTER_NAMES[] = {"cycles",   "instructions",  "l1d_misses",
+                                              "llc_misses", "branch_misses", "dtlb_misses"};
+static_assert(std::size(COUNTER_NAMES) == (std::size_t)Counter::TOTAL_COUNT);
+
+#if defined(__linux__)
+struct EventConfig
+{
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+constexpr auto cache_miss_config(std::uint64_t cache) -> std::uint64_t
+{
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+constexpr EventConfig EVENT_CONFIGS[] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, cache_miss_config(PERF_COUNT_HW_CACHE_L1D)},
+    {PERF_TYPE_HW_CACHE, cache_miss_config(PERF_COUNT_HW_CACHE_LL)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, cache_miss_config(PERF_COUNT_HW_CACHE_DTLB)},
+};
+static_assert(std::size(EVENT_CONFIGS) == (std::size_t)Counter::TOTAL_COUNT);
+
+/// @return file descriptor of the counter, or -1 if it can't be opened
+int open_counter(const EventConfig& event)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type;
+    attr.config = event.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // this thread, any CPU, no group
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+} // namespace
+
+auto to_string(Counter counter) -> std::string_view
+{
+    if (counter >= Counter::TOTAL_COUNT)
+        throw std::logic_error("Invalid counter=" + std::to_string((int)counter));
+    return COUNTER_NAMES[(std::size_t)counter];
+}
+
+PerfCounters::PerfCounters()
+{
+    _fds.fill(-1);
+
+#if defined(__linux__)
+    for (std::size_t i = 0; i < _fds.size(); ++i)
+        _fds[i] = open_counter(EVENT_CONFIGS[i]);
+#endif
+}
+
+PerfCounters::~PerfCounters()
+{
+#if defined(__linux__)
+    for (const int fd : _fds)
+        if (fd >= 0)
+            close(fd);
+#endif
+}
+
+bool PerfCounters::available() const
+{
+    return std::ranges::any_of(_fds, [](const int fd) { return fd >= 0; });
+}
+
+void PerfCounters::start()
+{
+#if defined(__linux__)
+    for (const int fd : _fds)
+    {
+        if (fd < 0)
+            continue;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+auto PerfCounters::stop() -> CounterValues
+{
+    CounterValues values{};
+
+#if defined(__linux__)
+    for (const int fd : _fds)
+        if (fd >= 0)
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+    for (std::size_t i = 0; i < _fds.size(); ++i)
+    {
+        if (_fds[i] < 0)
+            continue;
+
+        // value, time enabled, time running
+        std::uint64_t buf[3] = {};
+        if (read(_fds[i], buf, sizeof(buf)) != (ssize_t)sizeof(buf) || buf[2] == 0)
+            continue;
+
+        values[i] = (double)buf[0] * ((double)buf[1] / (double)buf[2]);
+    }
+#endif
+
+    return values;
+}
+
+} // namespace bs::bench
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace bs::bench
+{
+
+enum class Counter
+{
+    CYCLES,
+    INSTRUCTIONS,
+    L1D_MISSES,
+    LLC_MISSES,
+    BRANCH_MISSES,
+    DTLB_MISSES,
+
+    TOTAL_COUNT
+};
+
+auto to_string(Counter counter) -> std::string_view;
+
+/// @brief Counter values of a measured region, `std::nullopt` for counters the system refused to open.
+using CounterValues = std::array<std::optional<double>, (std::size_t)Counter::TOTAL_COUNT>;
+
+/// @brief Hardware performance counters of the calling thread, through Linux `perf_event_open(2)`.
+///
+/// Every counter is opened on its own, so a missing one (e.g. no dTLB event on this PMU)
+/// doesn't take the others down with it.
+/// Inside containers or with `perf_event_paranoid` too high, nothing can be opened:
+/// `available()` becomes `false` and every value reads as `std::nullopt`.
+/// On other platforms, this is always unavailable.
+class PerfCounters
+{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+public:
+    /// @return whether at least one counter could be opened
+    bool available() const;
+
+    /// @brief Resets and enables every opened counter.
+    void start();
+
+    /// @brief Disables every opened counter, and reads them.
+    /// Values are scaled up if the kernel multiplexed the counters.
+    auto stop() -> CounterValues;
+
+private:
+    std::array<int, (std::size_t)Counter::TOTAL_COUNT> _fds;
+};
+
+} // namespace bs::bench
@@ -0,0 +1,208 @@
+#include "Report.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace bs::bench
+{
+
+namespace
+{
+
+constexpr const char* CSV_HEADER =
+    "container,workload,phase,size,ops,ns_per_op,mops_per_sec,rss_delta_bytes,peak_rss_bytes";
+
+auto split_csv_line(const std::string& line) -> std::vector<std::string>
+{
+    std::vector<std::string> fields;
+    std::istringstream iss(line);
+    std::string field;
+    while (std::getline(iss, field, ','))
+        fields.push_back(field);
+    // `std::getline()` drops the trailing empty field
+    if (!line.empty() && line.back() == ',')
+        fields.emplace_back();
+    return fields;
+}
+
+auto counter(const Result& res, Counter cnt) -> const std::optional<double>&
+{
+    return res.counters_per_op[(std::size_t)cnt];
+}
+
+void print_counter(std::ostream& os, const std::optional<double>& value, int width)
+{
+    if (value)
+        os << std::setw(width) << *value;
+    else
+        os << std::setw(width) << "-";
+}
+
+} // namespace
+
+auto Result::key() const -> std::string
+{
+    return container + "/" + workload + "/" + phase + "/" + std::to_string(size);
+}
+
+void print_table(std::ostream& os, const std::vector<Result>& results)
+{
+    const auto old_flags = os.flags();
+
+    os << std::left << std::setw(20) << "container" << std::setw(14) << "workload" << std::setw(18) << "phase"
+       << std::right << std::setw(11) << "size" << std::setw(12) << "ns/op" << std::setw(12) << "Mops/s"
+       << std::setw(14) << "rss delta KiB" << std::setw(10) << "cyc/op" << std::setw(8) << "IPC" << std::setw(10)
+       << "L1D m/op" << std::setw(10) << "LLC m/op" << std::setw(10) << "br m/op" << std::setw(10) << "dTLB m/op"
+       << "\n";
+
+    for (const auto& res : results)
+    {
+        os << std::left << std::setw(20) << res.container << std::setw(14) << res.workload << std::setw(18)
+           << res.phase << std::right << std::setw(11) << res.size << std::fixed << std::setprecision(2)
+           << std::setw(12) << res.ns_per_op << std::setw(12) << res.mops_per_sec << std::setw(14)
+           << res.rss_delta_bytes / 1024;
+
+        const auto& cycles = counter(res, Counter::CYCLES);
+        const auto& instructions = counter(res, Counter::INSTRUCTIONS);
+        std::optional<double> ipc;
+        if (cycles && instructions && *cycles > 0)
+            ipc = *instructions / *cycles;
+
+        print_counter(os, cycles, 10);
+        print_counter(os, ipc, 8);
+        print_counter(os, counter(res, Counter::L1D_MISSES), 10);
+        print_counter(os, counter(res, Counter::LLC_MISSES), 10);
+        print_counter(os, counter(res, Counter::BRANCH_MISSES), 10);
+        print_counter(os, counter(res, Counter::DTLB_MISSES), 10);
+        os << "\n";
+    }
+
+    os.flags(old_flags);
+}
+
+void write_csv(std::ostream& os, const std::vector<Result>& results)
+{
+    os << CSV_HEADER;
+    for (int i = 0; i < (int)Counter::TOTAL_COUNT; ++i)
+        os << "," << to_string((Counter)i) << "_per_op";
+    os << "\n";
+
+    for (const auto& res : results)
+    {
+        os << res.container << "," << res.workload << "," << res.phase << "," << res.size << "," << res.ops << ","
+           << res.ns_per_op << "," << res.mops_per_sec << "," << res.rss_delta_bytes << "," << res.peak_rss_bytes;
+
+        // unavailable counters are left empty
+        for (const auto& value : res.counters_per_op)
+        {
+            os << ",";
+            if (value)
+                os << *value;
+        }
+        os << "\n";
+    }
+}
+
+void write_json(std::ostream& os, const std::vector<Result>& results)
+{
+    os << "[\n";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const auto& res = results[i];
+        os << "  {\"container\": \"" << res.container << "\", \"workload\": \"" << res.workload
+           << "\", \"phase\": \"" << res.phase << "\", \"size\": " << res.size << ", \"ops\": " << res.ops
+           << ", \"ns_per_op\": " << res.ns_per_op << ", \"mops_per_sec\": " << res.mops_per_sec
+           << ", \"rss_delta_bytes\": " << res.rss_delta_bytes << ", \"peak_rss_bytes\": " << res.peak_rss_bytes;
+
+        for (int cnt = 0; cnt < (int)Counter::TOTAL_COUNT; ++cnt)
+        {
+            const auto& value = res.counters_per_op[cnt];
+            os << ", \"" << to_string((Counter)cnt) << "_per_op\": ";
+            if (value)
+                os << *value;
+            else
+                os << "null";
+        }
+
+        os << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "]\n";
+}
+
+auto read_csv(std::istream& is) -> std::vector<Result>
+{
+    std::string line;
+    if (!std::getline(is, line))
+        throw std::runtime_error("Empty baseline CSV");
+
+    // map column names to indices, so that baselines with extra or reordered columns still work
+    std::unordered_map<std::string, std::size_t> columns;
+    {
+        const auto header = split_csv_line(line);
+        for (std::size_t i = 0; i < header.size(); ++i)
+            columns.emplace(header[i], i);
+    }
+
+    const auto column = [&columns](const char* name) -> std::size_t {
+        const auto it = columns.find(name);
+        if (it == columns.cend())
+            throw std::runtime_error(std::string("Baseline CSV lacks column `") + name + "`");
+        return it->second;
+    };
+
+    const std::size_t container_col = column("container");
+    const std::size_t workload_col = column("workload");
+    const std::size_t phase_col = column("phase");
+    const std::size_t size_col = column("size");
+    const std::size_t ns_per_op_col = column("ns_per_op");
+
+    std::vector<Result> results;
+    while (std::getline(is, line))
+    {
+        if (line.empty())
+            continue;
+
+        const auto fields = split_csv_line(line);
+        if (fields.size() != columns.size())
+            throw std::runtime_error("Malformed baseline CSV line: " + line);
+
+        Result res{};
+        res.container = fields[container_col];
+        res.workload = fields[workload_col];
+        res.phase = fields[phase_col];
+        res.size = std::stoull(fields[size_col]);
+        res.ns_per_op = std::stod(fields[ns_per_op_col]);
+        results.push_back(std::move(res));
+    }
+
+    return results;
+}
+
+auto find_regressions(const std::vector<Result>& results, const std::vector<Result>& baseline, double threshold)
+    -> std::vector<Regression>
+{
+    std::unordered_map<std::string, double> baseline_ns;
+    for (const auto& res : baseline)
+        baseline_ns.emplace(res.key(), res.ns_per_op);
+
+    std::vector<Regression> regressions;
+    for (const auto& res : results)
+    {
+        const auto it = baseline_ns.find(res.key());
+        if (it == baseline_ns.cend())
+            continue;
+
+        if (res.ns_per_op > it->second * (1.0 + threshold))
+            regressions.push_back(Regression{.result = &res, .baseline_ns_per_op = it->second});
+    }
+
+    return regressions;
+}
+
+} // namespace bs::bench
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "PerfCounters.hpp"
+
+namespace bs::bench
+{
+
+struct Result
+{
+    std::string container;
+    std::string workload;
+    std::string phase;
+    std::size_t size;
+
+    std::size_t ops;
+    double ns_per_op;
+    double mops_per_sec;
+
+    /// RSS after the phase, minus RSS before the container was built, in the first repetition,
+    /// as the later ones reuse the pages the allocator already holds
+    long long rss_delta_bytes;
+    /// peak RSS of the process while benchmarking this container on this workload, 0 if it can't be told apart
+    std::size_t peak_rss_bytes;
+
+    /// Hardware counters divided by `ops`
+    CounterValues counters_per_op;
+
+    auto key() const -> std::string;
+};
+
+struct Regression
+{
+    const Result* result;
+    double baseline_ns_per_op;
+};
+
+void print_table(std::ostream& os, const std::vector<Result>& results);
+
+void write_csv(std::ostream& os, const std::vector<Result>& results);
+void write_json(std::ostream& os, const std::vector<Result>& results);
+
+/// @brief Reads a CSV previously written by `write_csv()`.
+/// @throw std::runtime_error on malformed input
+auto read_csv(std::istream& is) -> std::vector<Result>;
+
+/// @param threshold relative slowdown to flag, e.g. `0.1` flags results 10% slower than the baseline
+/// @return results slower than their baseline counterpart by more than `threshold`
+auto find_regressions(const std::vector<Result>& results, const std::vector<Result>& baseline, double threshold)
+    -> std::vector<Regression>;
+
+} // namespace bs::bench
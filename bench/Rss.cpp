@@ -0,0 +1,72 @@
+#include "Rss.hpp"
+
+#if defined(__linux__)
+#include <fstream>
+#include <string>
+#endif
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace bs::bench
+{
+
+namespace
+{
+
+#if defined(__linux__)
+/// @param field e.g. "VmRSS:"
+auto read_proc_status_kib(const std::string& field) -> std::size_t
+{
+    std::ifstream status("/proc/self/status");
+    std::string token;
+    while (status >> token)
+    {
+        if (token == field)
+        {
+            std::size_t kib = 0;
+            status >> kib;
+            return kib;
+        }
+    }
+    return 0;
+}
+#endif
+
+} // namespace
+
+auto current_rss_bytes() -> std::size_t
+{
+#if defined(__linux__)
+    return read_proc_status_kib("VmRSS:") * 1024;
+#else
+    return 0;
+#endif
+}
+
+auto peak_rss_bytes() -> std::size_t
+{
+#if defined(__linux__)
+    return read_proc_status_kib("VmHWM:") * 1024;
+#else
+    return 0;
+#endif
+}
+
+bool reset_peak_rss()
+{
+#if defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+#if defined(__linux__)
+    // "5" resets the peak RSS, see proc(5)
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.flush();
+    return static_cast<bool>(clear_refs);
+#else
+    return false;
+#endif
+}
+
+} // namespace bs::bench
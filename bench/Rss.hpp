@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+namespace bs::bench
+{
+
+/// @return resident set size of this process in bytes, or 0 if unavailable on this platform
+auto current_rss_bytes() -> std::size_t;
+
+/// @return peak resident set size of this process in bytes, or 0 if unavailable on this platform
+auto peak_rss_bytes() -> std::size_t;
+
+/// @brief Releases the free heap memory to the OS, then resets the peak RSS to the current RSS,
+/// so that `peak_rss_bytes()` covers what runs next only.
+/// @return whether the peak was reset, which is unavailable on this platform or before Linux 4.0
+bool reset_peak_rss();
+
+} // namespace bs::bench
@@ -0,0 +1,272 @@
+#include "Workload.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+
+namespace bs::bench
+{
+
+namespace
+{
+
+constexpr std::string_view WORKLOAD_NAMES[] = {"sequential",   "random",   "zipfian",     "sawtooth",
+                                               "delete_heavy", "monotone", "increase_key"};
+constexpr std::string_view PHASE_NAMES[] = {"insert", "find",  "find_many", "find_sorted_batch",
+                                            "erase",  "mixed", "update"};
+
+static_assert(std::size(WORKLOAD_NAMES) == (std::size_t)WorkloadKind::TOTAL_COUNT);
+static_assert(std::size(PHASE_NAMES) == (std::size_t)Phase::TOTAL_COUNT);
+
+constexpr double ZIPF_THETA = 0.99;
+constexpr double DELETE_HEAVY_ERASE_RATIO = 0.75;
+constexpr double MONOTONE_ERASE_RATIO = 0.5;
+/// Keys pushed by `MONOTONE` are below the last popped one by up to this many average key gaps
+constexpr std::uint64_t MONOTONE_MAX_STEP_GAPS = 16;
+
+auto splitmix64(std::uint64_t x) -> std::uint64_t
+{
+    x += 0x9E3779B97F4A7C15;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EB;
+    return x ^ (x >> 31);
+}
+
+/// @brief Distinct (with overwhelming probability) keys in random order.
+auto random_keys(std::size_t size, std::uint64_t seed) -> std::vector<std::uint64_t>
+{
+    std::vector<std::uint64_t> keys(size);
+    for (std::size_t i = 0; i < size; ++i)
+        keys[i] = splitmix64(seed ^ splitmix64(i)) & ~MIXED_INSERT_BIT;
+    return keys;
+}
+
+auto shuffled(std::vector<std::uint64_t> keys, std::mt19937_64& rand) -> std::vector<std::uint64_t>
+{
+    std::ranges::shuffle(keys, rand);
+    return keys;
+}
+
+/// @brief Zipfian rank generator from "Quickly Generating Billion-Record Synthetic Databases" (Gray et al.)
+class ZipfianGenerator
+{
+public:
+    ZipfianGenerator(std::size_t size, double theta) : _size(size), _theta(theta)
+    {
+        double zeta_n = 0;
+        for (std::size_t i = 1; i <= size; ++i)
+            zeta_n += 1.0 / std::pow((double)i, theta);
+        const double zeta_2 = 1.0 + 1.0 / std::pow(2.0, theta);
+
+        _zeta_n = zeta_n;
+        _alpha = 1.0 / (1.0 - theta);
+        _eta = (1.0 - std::pow(2.0 / (double)size, 1.0 - theta)) / (1.0 - zeta_2 / zeta_n);
+    }
+
+    auto operator()(std::mt19937_64& rand) -> std::size_t
+    {
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rand);
+        const double uz = u * _zeta_n;
+
+        if (uz < 1.0)
+            return 0;
+        if (uz < 1.0 + std::pow(0.5, _theta))
+            return std::min<std::size_t>(1, _size - 1);
+
+        const auto rank = (std::size_t)((double)_size * std::pow(_eta * u - _eta + 1.0, _alpha));
+        return std::min(rank, _size - 1);
+    }
+
+private:
+    std::size_t _size;
+    double _theta;
+
+    double _zeta_n;
+    double _alpha;
+    double _eta;
+};
+
+} // namespace
+
+auto to_string(WorkloadKind kind) -> std::string_view
+{
+    if (kind >= WorkloadKind::TOTAL_COUNT)
+        throw std::logic_error("Invalid workload kind=" + std::to_string((int)kind));
+    return WORKLOAD_NAMES[(std::size_t)kind];
+}
+
+auto to_string(Phase phase) -> std::string_view
+{
+    if (phase >= Phase::TOTAL_COUNT)
+        throw std::logic_error("Invalid phase=" + std::to_string((int)phase));
+    return PHASE_NAMES[(std::size_t)phase];
+}
+
+auto parse_workload_kind(std::string_view str) -> std::optional<WorkloadKind>
+{
+    for (std::size_t i = 0; i < std::size(WORKLOAD_NAMES); ++i)
+        if (WORKLOAD_NAMES[i] == str)
+            return (WorkloadKind)i;
+    return std::nullopt;
+}
+
+auto make_workload(WorkloadKind kind, std::size_t size, std::uint64_t seed) -> Workload
+{
+    Workload workload{.kind = kind, .size = size, .phases = {}};
+    std::mt19937_64 rand(seed);
+
+    switch (kind)
+    {
+    case WorkloadKind::SEQUENTIAL: {
+        std::vector<std::uint64_t> keys(size);
+        for (std::size_t i = 0; i < size; ++i)
+            keys[i] = i;
+
+        workload.phases.push_back({Phase::INSERT, keys});
+        workload.phases.push_back({Phase::FIND, keys});
+        workload.phases.push_back({Phase::ERASE, std::move(keys)});
+        break;
+    }
+    case WorkloadKind::RANDOM: {
+        auto keys = random_keys(size, seed);
+
+        workload.phases.push_back({Phase::INSERT, keys});
+        workload.phases.push_back({Phase::FIND, shuffled(keys, rand)});
+        workload.phases.push_back({Phase::ERASE, shuffled(std::move(keys), rand)});
+        break;
+    }
+    case WorkloadKind::ZIPFIAN: {
+        auto keys = random_keys(size, seed);
+
+        std::vector<std::uint64_t> find_keys(size);
+        ZipfianGenerator zipf(size, ZIPF_THETA);
+        for (auto& key : find_keys)
+            key = keys[zipf(rand)];
+
+        workload.phases.push_back({Phase::INSERT, keys});
+        workload.phases.push_back({Phase::FIND, std::move(find_keys)});
+        workload.phases.push_back({Phase::ERASE, shuffled(std::move(keys), rand)});
+        break;
+    }
+    case WorkloadKind::SAWTOOTH: {
+        // ascending ramps of `period` keys, each ramp shifted by one
+        const auto period = std::max<std::size_t>(1, (std::size_t)std::sqrt((double)size));
+        const std::size_t stride = size / period + 1;
+
+        std::vector<std::uint64_t> keys(size);
+        for (std::size_t i = 0; i < size; ++i)
+            keys[i] = (i % period) * stride + i / period;
+
+        workload.phases.push_back({Phase::INSERT, keys});
+        workload.phases.push_back({Phase::FIND, keys});
+        workload.phases.push_back({Phase::ERASE, std::move(keys)});
+        break;
+    }
+    case WorkloadKind::DELETE_HEAVY: {
+        auto keys = random_keys(size, seed);
+        auto live = keys;
+        std::uint64_t next_key_index = size;
+
+        std::vector<std::uint64_t> mixed(size);
+        std::bernoulli_distribution erase_dist(DELETE_HEAVY_ERASE_RATIO);
+        for (auto& op : mixed)
+        {
+            if (!live.empty() && erase_dist(rand))
+            {
+                // swap-remove a random live key
+                const auto pos = std::uniform_int_distribution<std::size_t>(0, live.size() - 1)(rand);
+                op = live[pos];
+                live[pos] = live.back();
+                live.pop_back();
+            }
+            else
+            {
+                const std::uint64_t key = splitmix64(seed ^ splitmix64(next_key_index++)) & ~MIXED_INSERT_BIT;
+                live.push_back(key);
+                op = key | MIXED_INSERT_BIT;
+            }
+        }
+
+        workload.phases.push_back({Phase::INSERT, std::move(keys)});
+        workload.phases.push_back({Phase::MIXED, std::move(mixed)});
+        workload.phases.push_back({Phase::ERASE, shuffled(std::move(live), rand)});
+        break;
+    }
+    case WorkloadKind::MONOTONE: {
+        // simulates the max-heap the heaps are, to push keys just below the last popped one,
+        // like Dijkstra's algorithm does with reversed distances; erases take the top, so that trees match heaps
+        auto keys = random_keys(size, seed);
+        std::priority_queue<std::uint64_t> queue(keys.cbegin(), keys.cend());
+        std::unordered_set<std::uint64_t> used(keys.cbegin(), keys.cend());
+        std::uint64_t last_popped = ~MIXED_INSERT_BIT;
+
+        const std::uint64_t max_step = (~MIXED_INSERT_BIT / size) * MONOTONE_MAX_STEP_GAPS;
+        std::uniform_int_distribution<std::uint64_t> step_dist(0, max_step);
+
+        std::vector<std::uint64_t> mixed(size);
+        std::bernoulli_distribution erase_dist(MONOTONE_ERASE_RATIO);
+        for (auto& op : mixed)
+        {
+            if (!queue.empty() && erase_dist(rand))
+            {
+                op = last_popped = queue.top();
+                queue.pop();
+            }
+            else
+            {
+                // distinct keys, as heaps would overwrite a duplicate instead of holding both
+                std::uint64_t key;
+                do
+                    key = last_popped - std::min(last_popped, step_dist(rand));
+                while (!used.insert(key).second);
+
+                queue.push(key);
+                op = key | MIXED_INSERT_BIT;
+            }
+        }
+
+        std::vector<std::uint64_t> rest;
+        rest.reserve(queue.size());
+        for (; !queue.empty(); queue.pop())
+            rest.push_back(queue.top());
+
+        workload.phases.push_back({Phase::INSERT, std::move(keys)});
+        workload.phases.push_back({Phase::MIXED, std::move(mixed)});
+        workload.phases.push_back({Phase::ERASE, std::move(rest)});
+        break;
+    }
+    case WorkloadKind::INCREASE_KEY: {
+        auto keys = random_keys(size, seed);
+        auto priorities = keys;
+
+        std::vector<std::uint64_t> updates(2 * size);
+        std::uniform_int_distribution<std::size_t> pos_dist(0, size - 1);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            // raise by up to half the remaining room, which sends most of them towards the top
+            const std::size_t pos = pos_dist(rand);
+            std::uint64_t& priority = priorities[pos];
+            priority += std::uniform_int_distribution<std::uint64_t>(0, (~MIXED_INSERT_BIT - priority) / 2)(rand);
+
+            updates[2 * i] = keys[pos];
+            updates[2 * i + 1] = priority;
+        }
+
+        workload.phases.push_back({Phase::INSERT, keys});
+        workload.phases.push_back({Phase::UPDATE, std::move(updates)});
+        workload.phases.push_back({Phase::ERASE, shuffled(std::move(keys), rand)});
+        break;
+    }
+
+    default:
+        throw std::logic_error("Invalid workload kind=" + std::to_string((int)kind));
+    }
+
+    return workload;
+}
+
+} // namespace bs::bench
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace bs::bench
+{
+
+enum class WorkloadKind
+{
+    SEQUENTIAL,
+    RANDOM,
+    ZIPFIAN,
+    SAWTOOTH,
+    DELETE_HEAVY,
+    /// pushed keys never exceed the last popped one, as monotone heaps require
+    MONOTONE,
+    INCREASE_KEY,
+
+    TOTAL_COUNT
+};
+
+enum class Phase
+{
+    INSERT,
+    FIND,
+    /// `FIND` through a batched `find_many()`, for the containers that have it
+    FIND_MANY,
+    /// `FIND` keys sorted, through a finger-searching `find_sorted_batch()`, for the containers that have it
+    FIND_SORTED_BATCH,
+    ERASE,
+    MIXED,
+    /// keys come in (key, priority) pairs, raising the priority of a present key
+    UPDATE,
+
+    TOTAL_COUNT
+};
+
+/// @brief In the `MIXED` phase, keys with this bit set are inserts, the others are erases.
+inline constexpr std::uint64_t MIXED_INSERT_BIT = std::uint64_t(1) << 63;
+
+struct PhaseOps
+{
+    Phase phase;
+    std::vector<std::uint64_t> keys;
+};
+
+struct Workload
+{
+    WorkloadKind kind;
+    std::size_t size;
+
+    std::vector<PhaseOps> phases;
+};
+
+auto to_string(WorkloadKind kind) -> std::string_view;
+auto to_string(Phase phase) -> std::string_view;
+
+auto parse_workload_kind(std::string_view str) -> std::optional<WorkloadKind>;
+
+/// @brief Generates the key sequence of every phase of a workload.
+/// All keys are below `MIXED_INSERT_BIT`, so they can be used as priorities of heaps as well.
+auto make_workload(WorkloadKind kind, std::size_t size, std::uint64_t seed) -> Workload;
+
+} // namespace bs::bench
@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Containers.hpp"
+#include "PerfCounters.hpp"
+#include "Report.hpp"
+#include "Rss.hpp"
+#include "Workload.hpp"
+
+namespace
+{
+
+using namespace bs::bench;
+
+struct Options
+{
+    std::size_t min_size = 1'000;
+    std::size_t max_size = 1'000'000;
+    unsigned repeat = 3;
+    std::uint64_t seed = 42;
+
+    std::vector<std::string> containers;
+    std::vector<WorkloadKind> workloads;
+
+    std::string csv_path;
+    std::string json_path;
+    std::string baseline_path;
+    double threshold = 0.1;
+
+    bool perf = true;
+};
+
+constexpr const char* USAGE = R"(Usage: bs_bench [options]
+  --min-size N          smallest container size (default 1000)
+  --max-size N          largest container size, sizes step by x10 (default 1000000, up to 100000000)
+  --repeat N            repetitions per measurement, the fastest one is reported (default 3)
+  --seed N              workload random seed (default 42)
+  --containers a,b,...  RBTree, BSTree, std::map, AlterBinaryHeap, AlterDaryHeap4, AlterDaryHeap8,
+                        AlterPairingHeap, AlterMinMaxHeap, AlterRadixHeap, std::priority_queue (default all)
+  --workloads a,b,...   sequential, random, zipfian, sawtooth, delete_heavy, monotone, increase_key
+                        (default all)
+  --csv PATH            write results as CSV
+  --json PATH           write results as JSON
+  --baseline PATH       compare against a CSV written by `--csv`, exits with 1 on regressions
+  --threshold X         relative slowdown flagged as regression (default 0.1)
+  --no-perf             don't read hardware performance counters
+)";
+
+/// `Adapter::NAME` of every container `main()` runs
+constexpr std::array CONTAINER_NAMES{
+    RBTreeAdapter::NAME,           BSTreeAdapter::NAME,          StdMapAdapter::NAME,
+    AlterBinaryHeapAdapter::NAME,  AlterDaryHeap4Adapter::NAME,  AlterDaryHeap8Adapter::NAME,
+    AlterPairingHeapAdapter::NAME, AlterMinMaxHeapAdapter::NAME, AlterRadixHeapAdapter::NAME,
+    PriorityQueueAdapter::NAME,
+};
+
+// Keeps the results of `find()` alive, so the compiler can't drop the lookups
+volatile std::uint64_t g_sink;
+
+auto split_list(std::string_view str) -> std::vector<std::string>
+{
+    std::vector<std::string> items;
+    std::istringstream iss{std::string(str)};
+    std::string item;
+    while (std::getline(iss, item, ','))
+        if (!item.empty())
+            items.push_back(item);
+    return items;
+}
+
+auto parse_options(int argc, char* argv[]) -> std::optional<Options>
+{
+    Options opts;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+            return std::nullopt;
+        if (arg == "--no-perf")
+        {
+            opts.perf = false;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            std::cerr << "Missing value for " << arg << "\n";
+            return std::nullopt;
+        }
+        const std::string_view val = argv[++i];
+
+        if (arg == "--min-size")
+            opts.min_size = std::stoull(std::string(val));
+        else if (arg == "--max-size")
+            opts.max_size = std::stoull(std::string(val));
+        else if (arg == "--repeat")
+            opts.repeat = std::max(1u, (unsigned)std::stoul(std::string(val)));
+        else if (arg == "--seed")
+            opts.seed = std::stoull(std::string(val));
+        else if (arg == "--containers")
+        {
+            opts.containers = split_list(val);
+            for (const auto& name : opts.containers)
+            {
+                if (std::ranges::find(CONTAINER_NAMES, name) == CONTAINER_NAMES.end())
+                {
+                    std::cerr << "Unknown container: " << name << ", valid ones are:";
+                    for (const auto valid : CONTAINER_NAMES)
+                        std::cerr << " " << valid;
+                    std::cerr << "\n";
+                    return std::nullopt;
+                }
+            }
+        }
+        else if (arg == "--workloads")
+        {
+            for (const auto& name : split_list(val))
+            {
+                const auto kind = parse_workload_kind(name);
+                if (!kind)
+                {
+                    std::cerr << "Unknown workload: " << name << "\n";
+                    return std::nullopt;
+                }
+                opts.workloads.push_back(*kind);
+            }
+        }
+        else if (arg == "--csv")
+            opts.csv_path = val;
+        else if (arg == "--json")
+            opts.json_path = val;
+        else if (arg == "--baseline")
+            opts.baseline_path = val;
+        else if (arg == "--threshold")
+            opts.threshold = std::stod(std::string(val));
+        else
+        {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return std::nullopt;
+        }
+    }
+
+    if (opts.min_size == 0 || opts.min_size > opts.max_size)
+    {
+        std::cerr << "Invalid size range\n";
+        return std::nullopt;
+    }
+
+    if (opts.workloads.empty())
+        for (int i = 0; i < (int)WorkloadKind::TOTAL_COUNT; ++i)
+            opts.workloads.push_back((WorkloadKind)i);
+
+    return opts;
+}
+
+bool is_degenerate(WorkloadKind kind)
+{
+    return kind == WorkloadKind::SEQUENTIAL || kind == WorkloadKind::SAWTOOTH;
+}
+
+/// @brief Whether the workload never inserts above the last popped key, which `MONOTONE_ONLY` containers require
+bool is_monotone(WorkloadKind kind)
+{
+    // every other workload inserts everything before popping anything
+    return kind != WorkloadKind::DELETE_HEAVY;
+}
+
+/// @brief A phase of a workload, as run on a specific container
+struct PhaseRun
+{
+    Phase phase;
+    const std::vector<std::uint64_t>* keys;
+};
+
+template <typename Adapter>
+constexpr bool SUPPORTS_FIND_MANY = requires(const Adapter& adapter, std::span<const std::uint64_t> keys,
+                                             std::span<const std::uint64_t*> out) { adapter.find_many(keys, out); };
+
+template <typename Adapter>
+constexpr bool SUPPORTS_FIND_SORTED_BATCH =
+    requires(const Adapter& adapter, std::span<const std::uint64_t> keys, std::span<const std::uint64_t*> out) {
+        adapter.find_sorted_batch(keys, out);
+    };
+
+template <typename Adapter>
+constexpr bool SUPPORTS_UPDATE =
+    requires(Adapter& adapter, std::uint64_t key, std::uint64_t priority) { adapter.update(key, priority); };
+
+/// @brief Number of operations of a phase, `UPDATE` keys going in pairs
+auto op_count(const PhaseRun& run) -> std::size_t
+{
+    return (run.phase == Phase::UPDATE) ? run.keys->size() / 2 : run.keys->size();
+}
+
+/// @param sorted_find_keys keys of the `FIND` phase in ascending order, for `FIND_SORTED_BATCH`
+template <typename Adapter>
+auto phase_runs(const Workload& workload, std::vector<std::uint64_t>& sorted_find_keys) -> std::vector<PhaseRun>
+{
+    std::vector<PhaseRun> runs;
+    for (const auto& ops : workload.phases)
+    {
+        if (ops.phase == Phase::FIND)
+        {
+            if (Adapter::SUPPORTS_FIND)
+                runs.push_back(PhaseRun{.phase = Phase::FIND, .keys = &ops.keys});
+            if (SUPPORTS_FIND_MANY<Adapter>)
+                runs.push_back(PhaseRun{.phase = Phase::FIND_MANY, .keys = &ops.keys});
+            if (SUPPORTS_FIND_SORTED_BATCH<Adapter>)
+            {
+                sorted_find_keys = ops.keys;
+                std::ranges::sort(sorted_find_keys);
+                runs.push_back(PhaseRun{.phase = Phase::FIND_SORTED_BATCH, .keys = &sorted_find_keys});
+            }
+        }
+        else if (ops.phase != Phase::UPDATE || SUPPORTS_UPDATE<Adapter>)
+            runs.push_back(PhaseRun{.phase = ops.phase, .keys = &ops.keys});
+    }
+    return runs;
+}
+
+template <typename Adapter>
+void run_phase(Adapter& adapter, const PhaseRun& run, std::vector<const std::uint64_t*>& find_out)
+{
+    const auto& keys = *run.keys;
+    std::uint64_t found = 0;
+
+    switch (run.phase)
+    {
+    case Phase::INSERT:
+        for (const auto key : keys)
+            adapter.insert(key);
+        break;
+    case Phase::FIND:
+        for (const auto key : keys)
+            found += adapter.find(key);
+        break;
+    case Phase::FIND_MANY:
+        if constexpr (SUPPORTS_FIND_MANY<Adapter>)
+        {
+            adapter.find_many(keys, find_out);
+            found += keys.size() - (std::uint64_t)std::ranges::count(find_out, nullptr);
+        }
+        break;
+    case Phase::FIND_SORTED_BATCH:
+        if constexpr (SUPPORTS_FIND_SORTED_BATCH<Adapter>)
+        {
+            adapter.find_sorted_batch(keys, find_out);
+            found += keys.size() - (std::uint64_t)std::ranges::count(find_out, nullptr);
+        }
+        break;
+    case Phase::ERASE:
+        for (const auto key : keys)
+            adapter.erase(key);
+        break;
+    case Phase::MIXED:
+        for (const auto key : keys)
+        {
+            if (key & MIXED_INSERT_BIT)
+                adapter.insert(key & ~MIXED_INSERT_BIT);
+            else
+                adapter.erase(key);
+        }
+        break;
+    case Phase::UPDATE:
+        if constexpr (SUPPORTS_UPDATE<Adapter>)
+        {
+            for (std::size_t i = 0; i + 1 < keys.size(); i += 2)
+                adapter.update(keys[i], keys[i + 1]);
+        }
+        break;
+
+    default:
+        throw std::logic_error("Invalid phase=" + std::to_string((int)run.phase));
+    }
+
+    g_sink = g_sink + found;
+}
+
+template <typename Adapter>
+void run_container(const Options& opts, PerfCounters* perf, const Workload& workload, std::vector<Result>& results)
+{
+    if (!opts.containers.empty() && std::ranges::find(opts.containers, Adapter::NAME) == opts.containers.cend())
+        return;
+    if (is_degenerate(workload.kind) && workload.size > Adapter::MAX_DEGENERATE_SIZE)
+        return;
+    if (Adapter::MONOTONE_ONLY && !is_monotone(workload.kind))
+        return;
+
+    std::vector<std::uint64_t> sorted_find_keys;
+    const auto runs = phase_runs<Adapter>(workload, sorted_find_keys);
+    // so that the previous containers' peaks don't carry over
+    const bool peak_reset = reset_peak_rss();
+    std::vector<double> best_ns(runs.size(), std::numeric_limits<double>::infinity());
+    std::vector<long long> rss_delta(runs.size(), 0);
+    std::vector<CounterValues> best_counters(runs.size());
+
+    // output of the batched lookups
+    std::vector<const std::uint64_t*> find_out;
+    if (SUPPORTS_FIND_MANY<Adapter> || SUPPORTS_FIND_SORTED_BATCH<Adapter>)
+        find_out.resize(workload.size);
+
+    for (unsigned rep = 0; rep < opts.repeat; ++rep)
+    {
+        const auto rss_before = (long long)current_rss_bytes();
+        auto adapter = std::make_unique<Adapter>();
+
+        for (std::size_t i = 0; i < runs.size(); ++i)
+        {
+            if (perf)
+                perf->start();
+            const auto start = std::chrono::steady_clock::now();
+            run_phase(*adapter, runs[i], find_out);
+            const auto stop = std::chrono::steady_clock::now();
+            const CounterValues counters = perf ? perf->stop() : CounterValues{};
+
+            // counters are taken from the fastest repetition as well
+            const double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+            if (ns < best_ns[i])
+            {
+                best_ns[i] = ns;
+                best_counters[i] = counters;
+            }
+            // the later repetitions reuse the pages the allocator already holds
+            if (rep == 0)
+                rss_delta[i] = (long long)current_rss_bytes() - rss_before;
+        }
+    }
+
+    const std::size_t peak_rss = peak_reset ? peak_rss_bytes() : 0;
+    for (std::size_t i = 0; i < runs.size(); ++i)
+    {
+        const std::size_t ops = std::max<std::size_t>(1, op_count(runs[i]));
+        const double ns_per_op = best_ns[i] / (double)ops;
+
+        CounterValues counters_per_op{};
+        for (std::size_t cnt = 0; cnt < counters_per_op.size(); ++cnt)
+            if (best_counters[i][cnt])
+                counters_per_op[cnt] = *best_counters[i][cnt] / (double)ops;
+
+        results.push_back(Result{
+            .container = std::string(Adapter::NAME),
+            .workload = std::string(to_string(workload.kind)),
+            .phase = std::string(to_string(runs[i].phase)),
+            .size = workload.size,
+            .ops = op_count(runs[i]),
+            .ns_per_op = ns_per_op,
+            .mops_per_sec = (ns_per_op > 0) ? 1'000.0 / ns_per_op : 0.0,
+            .rss_delta_bytes = rss_delta[i],
+            .peak_rss_bytes = peak_rss,
+            .counters_per_op = counters_per_op,
+        });
+    }
+}
+
+template <typename Output>
+bool write_file(const std::string& path, Output output)
+{
+    if (path.empty())
+        return true;
+
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cerr << "Failed to open " << path << "\n";
+        return false;
+    }
+    output(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const auto opts = parse_options(argc, argv);
+    if (!opts)
+    {
+        std::cerr << USAGE;
+        return 2;
+    }
+
+#ifndef NDEBUG
+    std::cerr << "warning: assertions are enabled, configure with -DCMAKE_BUILD_TYPE=Release for meaningful numbers\n";
+#endif
+
+    std::unique_ptr<PerfCounters> perf;
+    if (opts->perf)
+    {
+        perf = std::make_unique<PerfCounters>();
+        if (!perf->available())
+        {
+            std::cerr << "warning: hardware performance counters are unavailable, reporting wall-clock only\n";
+            perf.reset();
+        }
+    }
+
+    std::vector<Result> results;
+
+    for (std::size_t size = opts->min_size; size <= opts->max_size; size *= 10)
+    {
+        for (const auto kind : opts->workloads)
+        {
+            const auto workload = make_workload(kind, size, opts->seed);
+
+            run_container<RBTreeAdapter>(*opts, perf.get(), workload, results);
+            run_container<BSTreeAdapter>(*opts, perf.get(), workload, results);
+            run_container<StdMapAdapter>(*opts, perf.get(), workload, results);
+            run_container<AlterBinaryHeapAdapter>(*opts, perf.get(), workload, results);
+            run_container<AlterDaryHeap4Adapter>(*opts, perf.get(), workload, results);
+            run_container<AlterDaryHeap8Adapter>(*opts, perf.get(), workload, results);
+            run_container<AlterPairingHeapAdapter>(*opts, perf.get(), workload, results);
+            run_container<AlterMinMaxHeapAdapter>(*opts, perf.get(), workload, results);
+            run_container<AlterRadixHeapAdapter>(*opts, perf.get(), workload, results);
+            run_container<PriorityQueueAdapter>(*opts, perf.get(), workload, results);
+        }
+
+        if (size > std::numeric_limits<std::size_t>::max() / 10)
+            break;
+    }
+
+    print_table(std::cout, results);
+
+    if (!write_file(opts->csv_path, [&results](std::ostream& os) { write_csv(os, results); }))
+        return 2;
+    if (!write_file(opts->json_path, [&results](std::ostream& os) { write_json(os, results); }))
+        return 2;
+
+    if (!opts->baseline_path.empty())
+    {
+        std::ifstream baseline_file(opts->baseline_path);
+        if (!baseline_file)
+        {
+            std::cerr << "Failed to open " << opts->baseline_path << "\n";
+            return 2;
+        }
+
+        const auto baseline = read_csv(baseline_file);
+        const auto regressions = find_regressions(results, baseline, opts->threshold);
+
+        for (const auto& reg : regressions)
+        {
+            std::cout << std::fixed << std::setprecision(2);
+            std::cout << "REGRESSION " << reg.result->key() << ": " << reg.baseline_ns_per_op << " -> "
+                      << reg.result->ns_per_op << " ns/op\n";
+        }
+
+        if (!regressions.empty())
+            return 1;
+        std::cout << "No regressions against " << opts->baseline_path << "\n";
+    }
+
+    return 0;
+}
@@ -4,37 +4,80 @@
 #include <bit>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <iterator>
+#include <ranges>
 #include <type_traits>
+#include <utility>
 
-#include <unordered_map>
 #include <vector>
 
+#include "DenseIdIndex.hpp"
+#include "FlatIdIndex.hpp"
+#include "HeapConstIterator.hpp"
+#include "HeapSortedIterator.hpp"
+#include "MemoryUsage.hpp"
+
 namespace bs
 {
 
-/// @brief A binary heap, which overwrites the `T` value if it is already in the heap.
+/// @brief A binary (or d-ary) heap, which overwrites the `T` value if it is already in the heap.
 /// To do this, member function `T::unique_id()` is used to find the same `T` object.
 ///
+/// Values are stored inline in a contiguous heap array, and found by id through a `FlatIdIndex`,
+/// so that neither sifting nor `pop()` chases pointers or frees memory.
+/// Integral ids known to be in `[0, IdCapacity)` can use a `DenseIdIndex` instead, which skips the hashing.
+///
+/// `push()` returns a `Handle` to the value, which stays valid until the value is popped or erased,
+/// so that `get()`, `update()` and `erase()` by handle skip the id lookup altogether.
+/// The index maps an id to its handle, and the handle to the heap index, so that sifting updates a single position.
+///
+/// Between `begin_bulk_update()` and `end_bulk_update()`, pushes and modifications defer their sifts,
+/// so that re-prioritizing a part of the heap costs at most a single O(n) rebuild.
+///
+/// A higher `Arity` makes the heap shallower, which speeds up `push()` and priority raises,
+/// at the cost of more comparisons per level of `pop()`.
+/// The children of a node are adjacent, and the best one is picked with a branch-free tournament.
+///
 /// @tparam T type of value to store
 /// @tparam Compare ordering of `T`
 /// @tparam UniqueIdHash hasher of `T::unique_id()`
 /// @tparam UniqueIdEqual equality check of `T::unique_id()`
+/// @tparam Arity number of children per node: 2, 4 or 8
+/// @tparam IdCapacity bound of the integral ids, for a `DenseIdIndex`; 0 (the default) for a `FlatIdIndex`
 template <typename T, typename Compare = std::less<T>,
           typename UniqueIdHash = std::hash<std::invoke_result_t<decltype(&T::unique_id), T>>,
-          typename UniqueIdEqual = std::equal_to<std::invoke_result_t<decltype(&T::unique_id), T>>>
+          typename UniqueIdEqual = std::equal_to<std::invoke_result_t<decltype(&T::unique_id), T>>,
+          std::size_t Arity = 2, std::size_t IdCapacity = 0>
 class AlterBinaryHeap
 {
 public:
     static_assert(std::is_member_function_pointer_v<decltype(&T::unique_id)>);
+    static_assert(Arity == 2 || Arity == 4 || Arity == 8, "`Arity` should be 2, 4 or 8");
 
     using UniqueId = std::invoke_result_t<decltype(&T::unique_id), T>;
+    static constexpr std::size_t ARITY = Arity;
+    /// pushes are free to go above the last popped value, unlike `AlterRadixHeap`
+    static constexpr bool MONOTONE = false;
+
+    /// @brief Stable reference to a value, returned by `push()`.
+    /// It outlives the sifts and overwrites of the value, but not its `pop()` or `erase()`,
+    /// after which `contains()` is false, even if the id is pushed again.
+    struct Handle
+    {
+        std::size_t entry;
+        std::uint32_t generation;
+
+        bool operator==(const Handle&) const = default;
+    };
 
 private:
     struct Node
     {
         T value;
-        std::size_t heap_index;
+        /// entry of the value in `_handles`
+        std::size_t handle;
 
         auto operator<=>(const Node& other) const -> std::weak_ordering
         {
@@ -50,152 +93,280 @@ private:
     };
 
 public:
-    /// @brief Random Access Iterator
-    struct ConstIterator
+    /// @brief Random Access Iterator, in heap array order
+    using ConstIterator = HeapConstIterator<T, Node>;
+    /// @brief Input Iterator, in priority order, see `sorted_view()`
+    using SortedIterator = HeapSortedIterator<T, Node, Arity>;
+
+public:
+    AlterBinaryHeap() = default;
+
+    AlterBinaryHeap(std::size_t reserve_size)
     {
-        friend class AlterBinaryHeap;
+        _index.reserve(reserve_size, on_slot_move());
+        _heap.reserve(reserve_size);
+        _handles.reserve(reserve_size);
+    }
 
-    private:
-        const std::vector<Node*>& _heap;
-        std::size_t _heap_index;
+    /// @brief Builds the heap from a range, see `assign()`.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    AlterBinaryHeap(InputIt first, Sentinel last)
+    {
+        assign(first, last);
+    }
 
-    private:
-        auto node() const -> const Node&
-        {
-            return *_heap[_heap_index];
-        }
+public: // Element access
+    auto top() const -> const T&
+    {
+        return _heap.front().value;
+    }
 
-    public:
-        ConstIterator(const std::vector<Node*>& heap, std::size_t heap_index) : _heap(heap), _heap_index(heap_index)
-        {
-        }
+public: // Capacity
+    bool empty() const
+    {
+        return _heap.empty();
+    }
 
-        auto operator*() const -> const T&
-        {
-            return node()->value;
-        }
+    auto size() const -> std::size_t
+    {
+        return _heap.size();
+    }
 
-        auto operator->() const -> const T*
-        {
-            return &node()->value;
-        }
+public: // Memory
+    /// @brief `node_bytes` are the used part of the heap array, `array_bytes` its unused capacity
+    /// and the bulk update scratch, and `bucket_bytes` the slots of the id index and the handles.
+    auto memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(size());
+    }
 
-        auto operator[](std::ptrdiff_t index) const -> const T&
-        {
-            return _heap[_heap_index + index]->value;
-        }
+    /// @brief Memory usage at the largest size since construction or the last `reset_peak()`.
+    /// The heap array and the index never shrink, so their current size is their peak.
+    auto peak_memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(_peak_size);
+    }
 
-        auto operator-(const ConstIterator& other) const -> std::ptrdiff_t
-        {
-            return _heap_index - other._heap_index;
-        }
+    void reset_peak()
+    {
+        _peak_size = size();
+    }
 
-        bool operator==(const ConstIterator& other) const
-        {
-            return _heap_index == other._heap_index;
-        }
+public: // Modifiers
+    /// @return handle to the value, the same one as before if the id was already in the heap
+    auto push(const T& value) -> Handle
+    {
+        return push_impl(value);
+    }
 
-        auto operator<=>(const ConstIterator& other) const
-        {
-            return _heap_index <=> other._heap_index;
-        }
+    auto push(T&& value) -> Handle
+    {
+        return push_impl(std::move(value));
+    }
 
-        auto operator+(std::ptrdiff_t diff) const -> ConstIterator
-        {
-            return ConstIterator(_heap, _heap_index + diff);
-        }
+    /// @brief Overwrites the value of `handle` with `value`, which should have the same `unique_id()`.
+    /// @return whether `handle` was still valid
+    bool update(Handle handle, const T& value)
+    {
+        return update_impl(handle, value);
+    }
 
-        auto operator+=(std::ptrdiff_t diff) -> ConstIterator&
-        {
-            _heap_index += diff;
-            return *this;
-        }
+    bool update(Handle handle, T&& value)
+    {
+        return update_impl(handle, std::move(value));
+    }
 
-        auto operator-(std::ptrdiff_t diff) const -> ConstIterator
-        {
-            return ConstIterator(_heap, _heap_index - diff);
-        }
+    /// @brief Replaces the contents with a range, in O(n).
+    /// Values with the same `unique_id()` are deduplicated, the last one wins like successive `push()`es.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    void assign(InputIt first, Sentinel last)
+    {
+        clear();
 
-        auto operator-=(std::ptrdiff_t diff) -> ConstIterator&
+        if constexpr (std::forward_iterator<InputIt>)
         {
-            _heap_index -= diff;
-            return *this;
+            const auto count = static_cast<std::size_t>(std::ranges::distance(first, last));
+            _index.reserve(count, on_slot_move());
+            _heap.reserve(count);
+            _handles.reserve(count);
         }
 
-        auto operator++() -> ConstIterator&
+        for (; first != last; ++first)
+            store(*first);
+
+        heapify();
+    }
+
+    /// @brief Pushes every value of a range, like successive `push()`es.
+    /// A batch large enough is stored first, then the heap is rebuilt at once in O(n), instead of sifting each value.
+    template <std::ranges::input_range Range>
+    void push_many(Range&& values)
+    {
+        if constexpr (std::ranges::forward_range<Range>)
         {
-            ++_heap_index;
-            return *this;
-        }
+            const auto count = static_cast<std::size_t>(std::ranges::distance(values));
 
-        auto operator++(int) -> ConstIterator
+            // a random value bubbles up O(1) levels on average, so sifting wins until the batch is a good part of n;
+            // a bulk update already defers the sifts, and a rebuild now would move the positions it recorded
+            if (!_bulk_updating && count * HEAPIFY_BATCH_DIVISOR >= size() + count)
+            {
+                reserve_more(count);
+                for_each_prefetched(values, [this](auto&& value) { store(std::forward<decltype(value)>(value)); });
+                heapify();
+            }
+            else
+                for_each_prefetched(values, [this](auto&& value) { push_impl(std::forward<decltype(value)>(value)); });
+        }
+        else
         {
-            auto it = *this;
-            operator++();
-            return it;
+            for (auto&& value : values)
+                push_impl(std::forward<decltype(value)>(value));
         }
+    }
 
-        auto operator--() -> ConstIterator&
+    /// @brief Moves the top `k` values (all of them if fewer) to `out`, best first, like `k` times `top()` and `pop()`.
+    /// A large enough `k` sorts the heap array instead, then rebuilds the heap from the rest.
+    /// @return `out` past the last moved value
+    template <std::weakly_incrementable OutputIt>
+    auto pop_k(std::size_t k, OutputIt out) -> OutputIt
+    {
+        assert(!_bulk_updating && "pop during a bulk update");
+        k = std::min(k, size());
+
+        if (k * SORTED_POP_K_DIVISOR < size())
         {
-            --_heap_index;
-            return *this;
+            for (; k > 0; --k)
+            {
+                *out = std::move(_heap.front().value);
+                ++out;
+                erase_at(0);
+            }
+            return out;
         }
 
-        auto operator--(int) -> ConstIterator
+        const auto kth = _heap.begin() + static_cast<std::ptrdiff_t>(k);
+        std::nth_element(_heap.begin(), kth, _heap.end(), std::greater<>{});
+        std::sort(_heap.begin(), kth, std::greater<>{});
+        sync_positions();
+
+        for (std::size_t i = 0; i < k; ++i)
         {
-            auto it = *this;
-            operator--();
-            return it;
+            _index.erase(_handles[_heap[i].handle].slot, on_slot_move());
+            release_handle(_heap[i].handle);
+            *out = std::move(_heap[i].value);
+            ++out;
         }
-    };
+        _heap.erase(_heap.begin(), _heap.begin() + static_cast<std::ptrdiff_t>(k));
 
-public:
-    AlterBinaryHeap() = default;
+        sync_positions();
+        heapify();
+        return out;
+    }
 
-    AlterBinaryHeap(std::size_t reserve_size)
+    /// @brief Moves every value of `other` in, like pushing them all with `push_many()`,
+    /// so that the values of `other` win on `unique_id()` collisions. `other` is left empty.
+    /// The handles of this heap stay valid, the ones of `other` don't carry over.
+    void meld(AlterBinaryHeap&& other)
     {
-        _map.reserve(reserve_size);
-        _heap.reserve(reserve_size);
+        if (&other == this)
+            return;
+
+        push_many(other._heap | std::views::transform([](Node& node) -> T&& { return std::move(node.value); }));
+        other.clear();
     }
 
-public: // Element access
-    auto top() const -> const T&
+    /// @brief Erases every value, and invalidates their handles.
+    void clear()
     {
-        return *_heap.front();
+        for (const Node& node : _heap)
+            release_handle(node.handle);
+        _heap.clear();
+        _index.clear();
+        _dirty.clear();
     }
 
-public: // Capacity
-    bool empty() const
+    void pop()
     {
-        return _heap.empty();
+        erase_at(0);
     }
 
-    auto size() const -> std::size_t
+    /// @brief Starts a bulk update: until `end_bulk_update()`, `push()`, `push_many()`, `update()` and `modify()`
+    /// (and its variants) only store the values, and record their positions.
+    /// In between, the heap order is broken: `top()` and `sorted_view()` are meaningless,
+    /// and neither popping nor erasing is allowed.
+    void begin_bulk_update()
     {
-        return _heap.size();
+        assert(!_bulk_updating && "nested bulk update");
+        _bulk_updating = true;
     }
 
-public: // Modifiers
-    void push(const T& value)
+    /// @brief Restores the heap after `begin_bulk_update()`, for `k` touched positions:
+    /// sifts down only them and their ancestors in O(k (log k + log n)),
+    /// unless rebuilding the whole heap in O(n) is cheaper.
+    void end_bulk_update()
     {
-        push_impl(value);
+        assert(_bulk_updating && "no bulk update to end");
+        _bulk_updating = false;
+
+        // the sort and the ancestors cost about log k + log n per touched position, the rebuild about 1 per value
+        const std::size_t touched = _dirty.size();
+        if (touched * (std::bit_width(touched) + std::bit_width(size())) >= size())
+            heapify();
+        else
+            heapify_dirty();
+        _dirty.clear();
     }
 
-    void push(T&& value)
+    bool bulk_updating() const
     {
-        push_impl(std::move(value));
+        return _bulk_updating;
     }
 
-    void pop()
+    /// @return whether `id` was found and erased
+    bool erase(const UniqueId& id)
     {
-        elem_swap(0, size() - 1);
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot == NPOS)
+            return false;
 
-        [[maybe_unused]] const bool erased = _map.erase(_heap.back()->value.unique_id());
-        assert(erased);
-        _heap.pop_back();
+        erase_at(_handles[_index.position(slot)].position);
+        return true;
+    }
 
-        if (!empty())
-            bubble_down(0);
+    /// @return whether `handle` was still valid, and its value erased
+    bool erase(Handle handle)
+    {
+        if (!contains(handle))
+            return false;
+
+        erase_at(_handles[handle.entry].position);
+        return true;
+    }
+
+    /// @brief Mutates the value of `id` in place with `fn(T&)`, and re-sifts it in whichever direction it moved.
+    /// `fn` must not change the `unique_id()`.
+    /// @return whether `id` was found
+    template <typename Fn>
+    bool modify(const UniqueId& id, Fn&& fn)
+    {
+        return modify_impl(id, std::forward<Fn>(fn), [this](std::size_t heap_index) {
+            if (!bubble_up(heap_index))
+                bubble_down(heap_index);
+        });
+    }
+
+    /// @brief `modify()` where `fn(T&)` only moves the value towards the top, so that it only bubbles up.
+    template <typename Fn>
+    bool increase_key(const UniqueId& id, Fn&& fn)
+    {
+        return modify_impl(id, std::forward<Fn>(fn), [this](std::size_t heap_index) { bubble_up(heap_index); });
+    }
+
+    /// @brief `modify()` where `fn(T&)` only moves the value away from the top, so that it only bubbles down.
+    template <typename Fn>
+    bool decrease_key(const UniqueId& id, Fn&& fn)
+    {
+        return modify_impl(id, std::forward<Fn>(fn), [this](std::size_t heap_index) { bubble_down(heap_index); });
     }
 
 public: // Iterators
@@ -219,39 +390,251 @@ public: // Iterators
         return cend();
     }
 
+    /// @brief Lazy range over the values in priority order, best first, which neither copies nor modifies the heap.
+    /// The first `k` values, e.g. `sorted_view() | std::views::take(k)`, cost O(k log k).
+    auto sorted_view() const -> std::ranges::subrange<SortedIterator, std::default_sentinel_t>
+    {
+        return {SortedIterator(_heap), std::default_sentinel};
+    }
+
 public: // Lookup
     auto find(const UniqueId& id) const -> ConstIterator
     {
-        const auto it = _map.find(id);
-        if (it != _map.cend())
-            return ConstIterator(_heap, it->second.heap_index);
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot != NPOS)
+            return ConstIterator(_heap, _handles[_index.position(slot)].position);
 
         return cend();
     }
 
+    /// @return whether `handle` still refers to a value in the heap
+    bool contains(Handle handle) const
+    {
+        return handle.entry < _handles.size() && _handles[handle.entry].generation == handle.generation;
+    }
+
+    /// @brief Value of `handle`, which should be valid, see `contains()`.
+    auto get(Handle handle) const -> const T&
+    {
+        assert(contains(handle));
+        return _heap[_handles[handle.entry].position].value;
+    }
+
 private:
     template <typename TVal>
-    void push_impl(TVal&& val)
+    auto push_impl(TVal&& val) -> Handle
+    {
+        const auto [entry, inserted] = store(std::forward<TVal>(val));
+        const std::size_t heap_index = _handles[entry].position;
+
+        if (_bulk_updating)
+            _dirty.push_back(heap_index);
+        else if (inserted)
+            bubble_up(heap_index);
+        else if (!bubble_up(heap_index))
+            bubble_down(heap_index);
+
+        return Handle{.entry = entry, .generation = _handles[entry].generation};
+    }
+
+    template <typename TVal>
+    bool update_impl(Handle handle, TVal&& val)
+    {
+        if (!contains(handle))
+            return false;
+
+        const std::size_t heap_index = _handles[handle.entry].position;
+        assert(UniqueIdEqual{}(_heap[heap_index].value.unique_id(), val.unique_id()) && "handle of another id");
+
+        _heap[heap_index].value = std::forward<TVal>(val);
+        if (_bulk_updating)
+            _dirty.push_back(heap_index);
+        else if (!bubble_up(heap_index))
+            bubble_down(heap_index);
+        return true;
+    }
+
+    /// @brief Overwrites the value with the same id, or appends it to the heap array, without restoring the heap.
+    /// @return handle entry of the value, and whether it was appended
+    template <typename TVal>
+    auto store(TVal&& val) -> std::pair<std::size_t, bool>
     {
         const auto uid = val.unique_id();
-        auto existing_iter = _map.find(uid);
+        const std::size_t slot = _index.find(uid, id_of());
 
-        if (existing_iter != _map.end())
+        if (slot != NPOS)
         {
-            existing_iter->second.value = T(std::forward<TVal>(val));
-            if (!bubble_up(existing_iter->second.heap_index))
-                bubble_down(existing_iter->second.heap_index);
+            const std::size_t entry = _index.position(slot);
+            _heap[_handles[entry].position].value = std::forward<TVal>(val);
+            return {entry, false};
         }
+
+        // whatever throws comes before the handle is taken, and the node is taken back if the index throws,
+        // so that a failed push leaves the heap as it was
+        const std::size_t entry = reserve_handle();
+        _heap.push_back(Node{.value = T(std::forward<TVal>(val)), .handle = entry});
+        std::size_t new_slot = NPOS;
+        try
+        {
+            new_slot = _index.insert(uid, entry, on_slot_move());
+        }
+        catch (...)
+        {
+            _heap.pop_back();
+            throw;
+        }
+
+        acquire_handle();
+        _handles[entry].position = size() - 1;
+        _handles[entry].slot = new_slot;
+        _peak_size = std::max(_peak_size, size());
+
+        return {entry, true};
+    }
+
+    void erase_at(std::size_t heap_index)
+    {
+        assert(heap_index < size());
+        assert(!_bulk_updating && "pop or erase during a bulk update");
+
+        elem_swap(heap_index, size() - 1);
+
+        const std::size_t entry = _heap.back().handle;
+        _index.erase(_handles[entry].slot, on_slot_move());
+        release_handle(entry);
+        _heap.pop_back();
+
+        // the last value moved into the hole can go either way
+        if (heap_index < size() && !bubble_up(heap_index))
+            bubble_down(heap_index);
+    }
+
+    template <typename Fn, typename Resift>
+    bool modify_impl(const UniqueId& id, Fn&& fn, Resift resift)
+    {
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot == NPOS)
+            return false;
+
+        const std::size_t heap_index = _handles[_index.position(slot)].position;
+        std::invoke(std::forward<Fn>(fn), _heap[heap_index].value);
+        assert(UniqueIdEqual{}(_heap[heap_index].value.unique_id(), id) && "`fn` changed the unique id");
+
+        if (_bulk_updating)
+            _dirty.push_back(heap_index);
         else
+            resift(heap_index);
+        return true;
+    }
+
+    /// @brief Calls `fn` on each value, while prefetching the index slots of the values a few steps ahead,
+    /// so that the cache misses of the lookups overlap.
+    template <std::ranges::forward_range Range, typename Fn>
+    void for_each_prefetched(Range& values, Fn fn)
+    {
+        const auto last = std::ranges::end(values);
+        auto ahead = std::ranges::begin(values);
+        for (std::size_t i = 0; i < PREFETCH_DISTANCE && ahead != last; ++i, ++ahead)
+            _index.prefetch((*ahead).unique_id());
+
+        for (auto it = std::ranges::begin(values); it != last; ++it)
+        {
+            if (ahead != last)
+            {
+                _index.prefetch((*ahead).unique_id());
+                ++ahead;
+            }
+            fn(*it);
+        }
+    }
+
+    /// @brief Floyd's bottom-up heap construction, with the positions in the index up to date
+    void heapify()
+    {
+        if (size() > 1)
+            for (std::size_t i = parent_index(size() - 1) + 1; i-- > 0;)
+                bubble_down(i);
+    }
+
+    /// @brief Floyd's construction restricted to the positions in `_dirty` and their ancestors,
+    /// as the subtrees without any of them are still heaps.
+    /// Sifts them from the last one, so that children come before their parents. As the parent is monotone
+    /// in the position, the parents of the sifted positions come in descending order too, and are merged
+    /// into the sorted touched ones as they come, each ancestor once.
+    /// O(k log k) for the sort, then O(1) comparisons per ancestor unless a touched value passes through it.
+    void heapify_dirty()
+    {
+        std::ranges::sort(_dirty, std::greater{});
+
+        std::vector<std::size_t> parents;
+        std::size_t next_parent = 0;
+        auto next_dirty = _dirty.begin();
+        std::size_t last = NPOS;
+
+        while (next_dirty != _dirty.end() || next_parent < parents.size())
         {
-            auto [new_item, inserted] = _map.try_emplace(uid, std::forward<TVal>(val), size());
-            assert(inserted);
-            _heap.push_back(&new_item->second);
+            const bool from_dirty = next_parent == parents.size() ||
+                                    (next_dirty != _dirty.end() && *next_dirty > parents[next_parent]);
+            const std::size_t pos = from_dirty ? *next_dirty++ : parents[next_parent++];
+            // touched twice, or reached from several children
+            if (pos == last)
+                continue;
 
-            bubble_up(new_item->second.heap_index);
+            last = pos;
+            bubble_down(pos);
+            if (pos > 0 && (parents.empty() || parents.back() != parent_index(pos)))
+                parents.push_back(parent_index(pos));
         }
     }
 
+    /// @brief Makes room for `count` more values, growing geometrically, so that repeated batches stay amortized O(1)
+    void reserve_more(std::size_t count)
+    {
+        const std::size_t new_size = size() + count;
+        _index.reserve(new_size, on_slot_move());
+        if (new_size > _heap.capacity())
+            _heap.reserve(std::max(new_size, _heap.capacity() * 2));
+        if (new_size > _handles.capacity())
+            _handles.reserve(std::max(new_size, _handles.capacity() * 2));
+    }
+
+    /// @brief Updates the positions of the handles after the heap array was reordered
+    void sync_positions()
+    {
+        for (std::size_t i = 0; i < size(); ++i)
+            _handles[_heap[i].handle].position = i;
+    }
+
+    /// @brief Adds a handle entry to the free list if it's empty, the only step of taking one which can throw.
+    /// @return the entry `acquire_handle()` takes next
+    auto reserve_handle() -> std::size_t
+    {
+        if (_free_handle == NPOS)
+        {
+            _handles.push_back(HandleEntry{});
+            _free_handle = _handles.size() - 1;
+        }
+        return _free_handle;
+    }
+
+    /// @brief Takes the first entry of the free list, which `reserve_handle()` made sure of.
+    auto acquire_handle() -> std::size_t
+    {
+        assert(_free_handle != NPOS);
+
+        const std::size_t entry = _free_handle;
+        _free_handle = _handles[entry].position;
+        return entry;
+    }
+
+    /// @brief Frees a handle entry, and invalidates the handles to it.
+    void release_handle(std::size_t entry)
+    {
+        _handles[entry].generation += 1;
+        _handles[entry].position = _free_handle;
+        _free_handle = entry;
+    }
+
 private:
     /// @return whether bubble-up actually took place or not
     bool bubble_up(std::size_t heap_index)
@@ -260,18 +643,14 @@ private:
 
         bool result = false;
 
-        while (true)
+        while (heap_index != 0)
         {
-            Node* parent = parent_node(heap_index);
-            if (!parent)
-                break;
-
-            Node* cur = _heap[heap_index];
-            if (*parent < *cur)
+            const std::size_t parent = parent_index(heap_index);
+            if (_heap[parent] < _heap[heap_index])
             {
-                elem_swap(heap_index, parent->heap_index);
+                elem_swap(heap_index, parent);
                 result = true;
-                heap_index = cur->heap_index;
+                heap_index = parent;
                 continue;
             }
             break;
@@ -289,40 +668,20 @@ private:
 
         while (true)
         {
-            Node* left = left_child_node(heap_index);
-            Node* right = right_child_node(heap_index);
+            const std::size_t first = first_child_index(heap_index);
             // 0 child
-            if (!left)
-            {
-                assert(!right);
+            if (first >= size())
                 break;
-            }
 
-            Node* cur = _heap[heap_index];
+            const std::size_t bigger =
+                (first + Arity <= size()) ? biggest_of<Arity>(first) : biggest_of_partial(first, size());
 
-            // 2 children
-            if (right)
+            if (_heap[heap_index] < _heap[bigger])
             {
-                Node* bigger = (*left < *right) ? right : left;
-
-                if (*cur < *bigger)
-                {
-                    elem_swap(heap_index, bigger->heap_index);
-                    result = true;
-                    heap_index = cur->heap_index;
-                    continue;
-                }
-            }
-            // 1 child
-            else
-            {
-                if (*cur < *left)
-                {
-                    elem_swap(heap_index, left->heap_index);
-                    result = true;
-                    heap_index = cur->heap_index;
-                    continue;
-                }
+                elem_swap(heap_index, bigger);
+                result = true;
+                heap_index = bigger;
+                continue;
             }
             break;
         }
@@ -330,6 +689,50 @@ private:
         return result;
     }
 
+    /// @brief Tournament over `Count` adjacent nodes, which compiles to conditional moves.
+    template <std::size_t Count>
+    auto biggest_of(std::size_t first) const -> std::size_t
+    {
+        if constexpr (Count == 1)
+            return first;
+        else
+        {
+            const std::size_t left = biggest_of<Count / 2>(first);
+            const std::size_t right = biggest_of<Count / 2>(first + Count / 2);
+            return (_heap[left] < _heap[right]) ? right : left;
+        }
+    }
+
+    /// @brief Biggest of the last children, fewer than `Arity`.
+    auto biggest_of_partial(std::size_t first, std::size_t last) const -> std::size_t
+    {
+        std::size_t biggest = first;
+        for (std::size_t i = first + 1; i < last; ++i)
+            if (_heap[biggest] < _heap[i])
+                biggest = i;
+        return biggest;
+    }
+
+private:
+    auto memory_usage_of(std::size_t node_count) const -> MemoryUsage
+    {
+        constexpr std::size_t MEMBER_BYTES = sizeof(T) + sizeof(std::size_t);
+        const std::size_t capacity = std::max(node_count, _heap.capacity());
+        const std::size_t handle_bytes = _handles.capacity() * sizeof(HandleEntry);
+        const std::size_t dirty_bytes = _dirty.capacity() * sizeof(std::size_t);
+
+        return MemoryUsage{
+            .node_count = node_count,
+            .node_bytes = node_count * sizeof(Node),
+            .padding_bytes = node_count * (sizeof(Node) - MEMBER_BYTES),
+            .overhead_bytes = allocation_overhead(capacity * sizeof(Node)) +
+                              allocation_overhead(_index.memory_bytes()) + allocation_overhead(handle_bytes) +
+                              allocation_overhead(dirty_bytes) + sizeof(*this),
+            .bucket_bytes = _index.memory_bytes() + handle_bytes,
+            .array_bytes = (capacity - node_count) * sizeof(Node) + dirty_bytes,
+        };
+    }
+
 private:
     void elem_swap(std::size_t left_index, std::size_t right_index)
     {
@@ -337,69 +740,117 @@ private:
         assert(right_index < size());
 
         using std::swap;
-        swap(_heap[left_index]->heap_index, _heap[right_index]->heap_index);
         swap(_heap[left_index], _heap[right_index]);
+        _handles[_heap[left_index].handle].position = left_index;
+        _handles[_heap[right_index].handle].position = right_index;
     }
 
 private:
-    /// @param index zero-based index
-    auto parent_node(std::size_t index) -> Node*
+    /// @brief Reads the id of a handle entry, for the id index
+    auto id_of() const
     {
-        if (index == 0)
-            return nullptr;
-
-        const auto parent_idx = parent_index(index);
-        assert(parent_idx < size());
-        return _heap[parent_idx];
+        return [this](std::size_t entry) -> decltype(auto) {
+            return _heap[_handles[entry].position].value.unique_id();
+        };
     }
 
-    /// @param index zero-based index
-    auto left_child_node(std::size_t index) -> Node*
+    /// @brief Follows the slot moves of the id index
+    auto on_slot_move()
     {
-        const auto child_idx = left_child_index(index);
-        if (child_idx < size())
-            return _heap[child_idx];
-        return nullptr;
-    }
-
-    /// @param index zero-based index
-    auto right_child_node(std::size_t index) -> Node*
-    {
-        const auto child_idx = right_child_index(index);
-        if (child_idx < size())
-            return _heap[child_idx];
-        return nullptr;
+        return [this](std::size_t entry, std::size_t slot) { _handles[entry].slot = slot; };
     }
 
 private:
     /// @param index zero-based index
     static auto parent_index(std::size_t index) -> std::size_t
     {
-        return (index + 1) / 2 - 1;
+        return (index - 1) / Arity;
     }
 
     /// @param index zero-based index
-    static auto left_child_index(std::size_t index) -> std::size_t
+    static auto first_child_index(std::size_t index) -> std::size_t
     {
-        return (index + 1) * 2 - 1;
-    }
-
-    /// @param index zero-based index
-    static auto right_child_index(std::size_t index) -> std::size_t
-    {
-        return ((index + 1) * 2 + 1) - 1;
+        return index * Arity + 1;
     }
 
 public:
     bool validate() const
     {
-        return std::ranges::is_heap(_heap, [](const Node* left, const Node* right) { return *left < *right; });
+        if (_index.size() != size())
+            return false;
+        for (std::size_t i = 0; i < size(); ++i)
+        {
+            const std::size_t entry = _heap[i].handle;
+            if (entry >= _handles.size() || _handles[entry].position != i)
+                return false;
+            if (_index.position(_handles[entry].slot) != entry)
+                return false;
+        }
+
+        // every other handle entry is free
+        std::size_t free_count = 0;
+        for (std::size_t entry = _free_handle; entry != NPOS; entry = _handles[entry].position)
+            if (++free_count > _handles.size())
+                return false;
+        if (free_count + size() != _handles.size())
+            return false;
+
+        for (std::size_t i = 1; i < size(); ++i)
+            if (_heap[parent_index(i)] < _heap[i])
+                return false;
+        return true;
     }
 
 private:
-    std::unordered_map<UniqueId, Node, UniqueIdHash, UniqueIdEqual> _map;
+    using IdIndex = IdIndexFor<UniqueId, UniqueIdHash, UniqueIdEqual, IdCapacity>;
+    static constexpr std::size_t NPOS = IdIndex::NPOS;
+
+    /// `pop_k()` sorts the heap array rather than popping one by one, from `size() / SORTED_POP_K_DIVISOR` values on
+    static constexpr std::size_t SORTED_POP_K_DIVISOR = 8;
+
+    /// `push_many()` rebuilds the heap rather than sifting each value, from `size() / HEAPIFY_BATCH_DIVISOR` values on
+    static constexpr std::size_t HEAPIFY_BATCH_DIVISOR = 4;
+
+    /// values ahead whose index slots `push_many()` prefetches
+    static constexpr std::size_t PREFETCH_DISTANCE = 8;
+
+    struct HandleEntry
+    {
+        /// heap index of the value, or the next free entry while free
+        std::size_t position = NPOS;
+        /// slot of the id in `_index`
+        std::size_t slot = NPOS;
+        /// bumped on release, so that the handles to the previous value are told apart
+        std::uint32_t generation = 0;
+    };
+
+private:
+    /// maps an id to its entry in `_handles`
+    IdIndex _index;
+
+    std::vector<Node> _heap;
 
-    std::vector<Node*> _heap;
+    std::vector<HandleEntry> _handles;
+    /// head of the free list of `_handles`, threaded through `HandleEntry::position`
+    std::size_t _free_handle = NPOS;
+
+    std::size_t _peak_size = 0;
+
+    /// heap positions stored to during a bulk update, possibly repeated
+    std::vector<std::size_t> _dirty;
+    bool _bulk_updating = false;
 };
 
+/// @brief `AlterBinaryHeap` with `Arity` children per node.
+template <typename T, std::size_t Arity, typename Compare = std::less<T>>
+using AlterDaryHeap =
+    AlterBinaryHeap<T, Compare, std::hash<std::invoke_result_t<decltype(&T::unique_id), T>>,
+                    std::equal_to<std::invoke_result_t<decltype(&T::unique_id), T>>, Arity>;
+
+/// @brief `AlterBinaryHeap` over integral ids in `[0, IdCapacity)`, found through a `DenseIdIndex`.
+template <typename T, std::size_t IdCapacity, typename Compare = std::less<T>, std::size_t Arity = 2>
+using AlterDenseIdHeap =
+    AlterBinaryHeap<T, Compare, std::hash<std::invoke_result_t<decltype(&T::unique_id), T>>,
+                    std::equal_to<std::invoke_result_t<decltype(&T::unique_id), T>>, Arity, IdCapacity>;
+
 } // namespace bs
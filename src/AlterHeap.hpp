@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+#include "AlterBinaryHeap.hpp"
+#include "AlterMinMaxHeap.hpp"
+#include "AlterPairingHeap.hpp"
+#include "AlterRadixHeap.hpp"
+
+namespace bs
+{
+
+/// @brief Heap engine of `AlterHeap`: `AlterBinaryHeap` with `Arity` children per node.
+/// The default, good at everything and best at `pop()`.
+/// A non-zero `IdCapacity` indexes integral ids in `[0, IdCapacity)` directly, see `DenseIdIndex`.
+template <std::size_t Arity = 2, std::size_t IdCapacity = 0>
+struct DaryHeapEngine
+{
+    template <typename T, typename Compare, typename UniqueIdHash, typename UniqueIdEqual>
+    using Heap = AlterBinaryHeap<T, Compare, UniqueIdHash, UniqueIdEqual, Arity, IdCapacity>;
+};
+
+/// @brief Heap engine of `AlterHeap`: `AlterPairingHeap`, for O(1) `push()` and `increase_key()`.
+struct PairingHeapEngine
+{
+    template <typename T, typename Compare, typename UniqueIdHash, typename UniqueIdEqual>
+    using Heap = AlterPairingHeap<T, Compare, UniqueIdHash, UniqueIdEqual>;
+};
+
+/// @brief Heap engine of `AlterHeap`: `AlterMinMaxHeap`, which also pops the worst value, with `pop_min()`.
+struct MinMaxHeapEngine
+{
+    template <typename T, typename Compare, typename UniqueIdHash, typename UniqueIdEqual>
+    using Heap = AlterMinMaxHeap<T, Compare, UniqueIdHash, UniqueIdEqual>;
+};
+
+/// @brief Heap engine of `AlterHeap`: `AlterRadixHeap`, for monotone unsigned integer priorities.
+/// It orders by `PriorityOf` and ignores `Compare`, which should agree with it.
+template <typename PriorityOf>
+struct RadixHeapEngine
+{
+    template <typename T, typename Compare, typename UniqueIdHash, typename UniqueIdEqual>
+    using Heap = AlterRadixHeap<T, PriorityOf, UniqueIdHash, UniqueIdEqual>;
+};
+
+/// @brief Heap which overwrites the `T` value with the same `T::unique_id()`, on the engine picked by `Engine`.
+/// All the engines have the interface of `AlterBinaryHeap`, but for its handles, `meld()`, `clear()` and bulk updates.
+template <typename T, typename Engine = DaryHeapEngine<>, typename Compare = std::less<T>,
+          typename UniqueIdHash = std::hash<std::invoke_result_t<decltype(&T::unique_id), T>>,
+          typename UniqueIdEqual = std::equal_to<std::invoke_result_t<decltype(&T::unique_id), T>>>
+using AlterHeap = typename Engine::template Heap<T, Compare, UniqueIdHash, UniqueIdEqual>;
+
+} // namespace bs
@@ -0,0 +1,547 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "FlatIdIndex.hpp"
+#include "HeapConstIterator.hpp"
+#include "MemoryUsage.hpp"
+
+namespace bs
+{
+
+/// @brief A min-max heap with the interface of `AlterBinaryHeap`, which overwrites the `T` value
+/// if it is already in the heap, found by `T::unique_id()`.
+///
+/// Both extremes are at hand in O(1), `top_max()` (alias `top()`) and `top_min()`, and either is popped in O(log n),
+/// from a single heap array and id index, rather than two heaps holding a copy of every value each.
+///
+/// Levels alternate: a node on an even level (the root's) isn't below any of its descendants,
+/// and a node on an odd level isn't above any of them.
+///
+/// @tparam T type of value to store
+/// @tparam Compare ordering of `T`
+/// @tparam UniqueIdHash hasher of `T::unique_id()`
+/// @tparam UniqueIdEqual equality check of `T::unique_id()`
+template <typename T, typename Compare = std::less<T>,
+          typename UniqueIdHash = std::hash<std::invoke_result_t<decltype(&T::unique_id), T>>,
+          typename UniqueIdEqual = std::equal_to<std::invoke_result_t<decltype(&T::unique_id), T>>>
+class AlterMinMaxHeap
+{
+public:
+    static_assert(std::is_member_function_pointer_v<decltype(&T::unique_id)>);
+
+    using UniqueId = std::invoke_result_t<decltype(&T::unique_id), T>;
+    /// pushes are free to go above the last popped value, unlike `AlterRadixHeap`
+    static constexpr bool MONOTONE = false;
+
+private:
+    using IdIndex = FlatIdIndex<UniqueId, UniqueIdHash, UniqueIdEqual>;
+    static constexpr std::size_t NPOS = IdIndex::NPOS;
+
+    struct Node
+    {
+        T value;
+        /// slot of `value.unique_id()` in `_index`
+        std::size_t slot;
+    };
+
+public:
+    /// @brief Random Access Iterator, in heap array order
+    using ConstIterator = HeapConstIterator<T, Node>;
+
+public:
+    AlterMinMaxHeap() = default;
+
+    AlterMinMaxHeap(std::size_t reserve_size)
+    {
+        _index.reserve(reserve_size, on_slot_move());
+        _heap.reserve(reserve_size);
+    }
+
+    /// @brief Builds the heap from a range, see `assign()`.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    AlterMinMaxHeap(InputIt first, Sentinel last)
+    {
+        assign(first, last);
+    }
+
+public: // Element access
+    auto top() const -> const T&
+    {
+        return top_max();
+    }
+
+    auto top_max() const -> const T&
+    {
+        return _heap.front().value;
+    }
+
+    auto top_min() const -> const T&
+    {
+        return _heap[min_index()].value;
+    }
+
+public: // Capacity
+    bool empty() const
+    {
+        return _heap.empty();
+    }
+
+    auto size() const -> std::size_t
+    {
+        return _heap.size();
+    }
+
+public: // Memory
+    /// @brief `node_bytes` are the used part of the heap array, `array_bytes` its unused capacity,
+    /// and `bucket_bytes` the slots of the id index.
+    auto memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(size());
+    }
+
+    /// @brief Memory usage at the largest size since construction or the last `reset_peak()`.
+    /// The heap array and the index never shrink, so their current size is their peak.
+    auto peak_memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(_peak_size);
+    }
+
+    void reset_peak()
+    {
+        _peak_size = size();
+    }
+
+public: // Modifiers
+    void push(const T& value)
+    {
+        push_impl(value);
+    }
+
+    void push(T&& value)
+    {
+        push_impl(std::move(value));
+    }
+
+    /// @brief Replaces the contents with a range, in O(n).
+    /// Values with the same `unique_id()` are deduplicated, the last one wins like successive `push()`es.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    void assign(InputIt first, Sentinel last)
+    {
+        _heap.clear();
+        _index.clear();
+
+        if constexpr (std::forward_iterator<InputIt>)
+        {
+            const auto count = static_cast<std::size_t>(std::ranges::distance(first, last));
+            _index.reserve(count, on_slot_move());
+            _heap.reserve(count);
+        }
+
+        for (; first != last; ++first)
+            store(*first);
+
+        // Floyd's bottom-up heap construction works level by level alike
+        if (size() > 1)
+            for (std::size_t i = parent_index(size() - 1) + 1; i-- > 0;)
+                bubble_down(i);
+    }
+
+    /// @brief Pushes every value of a range, like successive `push()`es.
+    template <std::ranges::input_range Range>
+    void push_many(Range&& values)
+    {
+        if constexpr (std::ranges::forward_range<Range>)
+        {
+            const auto count = static_cast<std::size_t>(std::ranges::distance(values));
+            _index.reserve(size() + count, on_slot_move());
+            _heap.reserve(size() + count);
+        }
+
+        for (auto&& value : values)
+            push_impl(std::forward<decltype(value)>(value));
+    }
+
+    /// @brief Moves the top `k` values (all of them if fewer) to `out`, best first, like `k` times `top()` and `pop()`.
+    /// @return `out` past the last moved value
+    template <std::weakly_incrementable OutputIt>
+    auto pop_k(std::size_t k, OutputIt out) -> OutputIt
+    {
+        k = std::min(k, size());
+        for (; k > 0; --k)
+        {
+            *out = std::move(_heap.front().value);
+            ++out;
+            erase_at(0);
+        }
+        return out;
+    }
+
+    void pop()
+    {
+        pop_max();
+    }
+
+    void pop_max()
+    {
+        erase_at(0);
+    }
+
+    void pop_min()
+    {
+        erase_at(min_index());
+    }
+
+    /// @return whether `id` was found and erased
+    bool erase(const UniqueId& id)
+    {
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot == NPOS)
+            return false;
+
+        erase_at(_index.position(slot));
+        return true;
+    }
+
+    /// @brief Mutates the value of `id` in place with `fn(T&)`, and re-sifts it in whichever direction it moved.
+    /// `fn` must not change the `unique_id()`.
+    /// @return whether `id` was found
+    template <typename Fn>
+    bool modify(const UniqueId& id, Fn&& fn)
+    {
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot == NPOS)
+            return false;
+
+        const std::size_t heap_index = _index.position(slot);
+        std::invoke(std::forward<Fn>(fn), _heap[heap_index].value);
+        assert(UniqueIdEqual{}(_heap[heap_index].value.unique_id(), id) && "`fn` changed the unique id");
+
+        resift(heap_index);
+        return true;
+    }
+
+    /// @brief Same as `modify()`: a raised value on a min level may still have to go down, and vice versa.
+    template <typename Fn>
+    bool increase_key(const UniqueId& id, Fn&& fn)
+    {
+        return modify(id, std::forward<Fn>(fn));
+    }
+
+    /// @brief Same as `modify()`, see `increase_key()`.
+    template <typename Fn>
+    bool decrease_key(const UniqueId& id, Fn&& fn)
+    {
+        return modify(id, std::forward<Fn>(fn));
+    }
+
+public: // Iterators
+    auto cbegin() const noexcept -> ConstIterator
+    {
+        return ConstIterator(_heap, 0);
+    }
+
+    auto begin() const noexcept -> ConstIterator
+    {
+        return cbegin();
+    }
+
+    auto cend() const noexcept -> ConstIterator
+    {
+        return ConstIterator(_heap, size());
+    }
+
+    auto end() const noexcept -> ConstIterator
+    {
+        return cend();
+    }
+
+public: // Lookup
+    auto find(const UniqueId& id) const -> ConstIterator
+    {
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot != NPOS)
+            return ConstIterator(_heap, _index.position(slot));
+
+        return cend();
+    }
+
+private:
+    template <typename TVal>
+    void push_impl(TVal&& val)
+    {
+        const auto [heap_index, inserted] = store(std::forward<TVal>(val));
+
+        if (inserted)
+            bubble_up(heap_index);
+        else
+            resift(heap_index);
+    }
+
+    /// @brief Overwrites the value with the same id, or appends it to the heap array, without restoring the heap.
+    /// @return heap index of the value, and whether it was appended
+    template <typename TVal>
+    auto store(TVal&& val) -> std::pair<std::size_t, bool>
+    {
+        const auto uid = val.unique_id();
+        const std::size_t slot = _index.find(uid, id_of());
+
+        if (slot != NPOS)
+        {
+            const std::size_t heap_index = _index.position(slot);
+            _heap[heap_index].value = std::forward<TVal>(val);
+            return {heap_index, false};
+        }
+
+        const std::size_t heap_index = size();
+        const std::size_t new_slot = _index.insert(uid, heap_index, on_slot_move());
+        _heap.push_back(Node{.value = T(std::forward<TVal>(val)), .slot = new_slot});
+        _peak_size = std::max(_peak_size, size());
+
+        return {heap_index, true};
+    }
+
+    void erase_at(std::size_t heap_index)
+    {
+        assert(heap_index < size());
+
+        elem_swap(heap_index, size() - 1);
+
+        _index.erase(_heap.back().slot, on_slot_move());
+        _heap.pop_back();
+
+        if (heap_index < size())
+            resift(heap_index);
+    }
+
+    /// @brief Restores the heap after the value at `heap_index` was replaced by an arbitrary one.
+    void resift(std::size_t heap_index)
+    {
+        // going up may bring down the parent, which the subtree of `heap_index` can be on the wrong side of
+        bubble_up(heap_index);
+        bubble_down(heap_index);
+    }
+
+    auto min_index() const -> std::size_t
+    {
+        assert(!empty());
+
+        if (size() <= 2)
+            return size() - 1;
+        return less(2, 1) ? 2 : 1;
+    }
+
+private:
+    /// @return whether bubble-up actually took place or not
+    bool bubble_up(std::size_t heap_index)
+    {
+        assert(heap_index < size());
+
+        if (heap_index == 0)
+            return false;
+
+        // a value on the wrong side of its parent crosses over to the levels of the parent first
+        const std::size_t parent = parent_index(heap_index);
+        if (is_max_level(heap_index))
+        {
+            if (less(heap_index, parent))
+            {
+                elem_swap(heap_index, parent);
+                bubble_up_levels<false>(parent);
+                return true;
+            }
+            return bubble_up_levels<true>(heap_index);
+        }
+
+        if (less(parent, heap_index))
+        {
+            elem_swap(heap_index, parent);
+            bubble_up_levels<true>(parent);
+            return true;
+        }
+        return bubble_up_levels<false>(heap_index);
+    }
+
+    /// @brief Bubbles up through the grandparents, on the max levels if `Max`, on the min levels otherwise.
+    template <bool Max>
+    bool bubble_up_levels(std::size_t heap_index)
+    {
+        bool result = false;
+
+        while (heap_index >= 3)
+        {
+            const std::size_t grandparent = parent_index(parent_index(heap_index));
+            if (!better<Max>(heap_index, grandparent))
+                break;
+
+            elem_swap(heap_index, grandparent);
+            result = true;
+            heap_index = grandparent;
+        }
+
+        return result;
+    }
+
+    void bubble_down(std::size_t heap_index)
+    {
+        assert(heap_index < size());
+
+        if (is_max_level(heap_index))
+            bubble_down_levels<true>(heap_index);
+        else
+            bubble_down_levels<false>(heap_index);
+    }
+
+    /// @brief Bubbles down through the grandchildren, on the max levels if `Max`, on the min levels otherwise.
+    template <bool Max>
+    void bubble_down_levels(std::size_t heap_index)
+    {
+        while (true)
+        {
+            const std::size_t first_child = first_child_index(heap_index);
+            // 0 child
+            if (first_child >= size())
+                break;
+
+            // best of the up to 2 children and 4 grandchildren
+            std::size_t best = first_child;
+            if (first_child + 1 < size() && better<Max>(first_child + 1, best))
+                best = first_child + 1;
+            const std::size_t first_grandchild = first_child_index(first_child);
+            for (std::size_t i = first_grandchild; i < std::min(first_grandchild + 4, size()); ++i)
+                if (better<Max>(i, best))
+                    best = i;
+
+            if (!better<Max>(best, heap_index))
+                break;
+
+            elem_swap(heap_index, best);
+            // a child is on the opposite levels, and has no better descendant
+            if (best < first_grandchild)
+                break;
+
+            // the value brought down to a grandchild may be on the wrong side of its parent
+            const std::size_t parent = parent_index(best);
+            if (better<Max>(parent, best))
+                elem_swap(best, parent);
+            heap_index = best;
+        }
+    }
+
+    /// @return whether the value at `left` goes above the one at `right` on a max level if `Max`,
+    /// below it on a min level otherwise
+    template <bool Max>
+    bool better(std::size_t left, std::size_t right) const
+    {
+        return Max ? less(right, left) : less(left, right);
+    }
+
+    bool less(std::size_t left, std::size_t right) const
+    {
+        return Compare{}(_heap[left].value, _heap[right].value);
+    }
+
+private:
+    auto memory_usage_of(std::size_t node_count) const -> MemoryUsage
+    {
+        constexpr std::size_t MEMBER_BYTES = sizeof(T) + sizeof(std::size_t);
+        const std::size_t capacity = std::max(node_count, _heap.capacity());
+
+        return MemoryUsage{
+            .node_count = node_count,
+            .node_bytes = node_count * sizeof(Node),
+            .padding_bytes = node_count * (sizeof(Node) - MEMBER_BYTES),
+            .overhead_bytes = allocation_overhead(capacity * sizeof(Node)) +
+                              allocation_overhead(_index.memory_bytes()) + sizeof(*this),
+            .bucket_bytes = _index.memory_bytes(),
+            .array_bytes = (capacity - node_count) * sizeof(Node),
+        };
+    }
+
+private:
+    void elem_swap(std::size_t left_index, std::size_t right_index)
+    {
+        assert(left_index < size());
+        assert(right_index < size());
+
+        using std::swap;
+        swap(_heap[left_index], _heap[right_index]);
+        _index.position(_heap[left_index].slot) = left_index;
+        _index.position(_heap[right_index].slot) = right_index;
+    }
+
+private:
+    /// @brief Reads the id at a heap index, for `FlatIdIndex`
+    auto id_of() const
+    {
+        return [this](std::size_t heap_index) -> decltype(auto) { return _heap[heap_index].value.unique_id(); };
+    }
+
+    /// @brief Follows the slot moves of `FlatIdIndex`
+    auto on_slot_move()
+    {
+        return [this](std::size_t heap_index, std::size_t slot) { _heap[heap_index].slot = slot; };
+    }
+
+private:
+    /// @param index zero-based index
+    static auto parent_index(std::size_t index) -> std::size_t
+    {
+        return (index - 1) / 2;
+    }
+
+    /// @param index zero-based index
+    static auto first_child_index(std::size_t index) -> std::size_t
+    {
+        return index * 2 + 1;
+    }
+
+    /// @brief Even levels, the root's included, are max levels.
+    static bool is_max_level(std::size_t index)
+    {
+        return std::bit_width(index + 1) % 2 == 1;
+    }
+
+public:
+    bool validate() const
+    {
+        if (_index.size() != size())
+            return false;
+        for (std::size_t i = 0; i < size(); ++i)
+            if (_index.position(_heap[i].slot) != i)
+                return false;
+
+        // checking against the parent and the grandparent covers every ancestor, by transitivity
+        for (std::size_t i = 1; i < size(); ++i)
+        {
+            const std::size_t parent = parent_index(i);
+            if (is_max_level(parent) ? less(parent, i) : less(i, parent))
+                return false;
+            if (i >= 3)
+            {
+                const std::size_t grandparent = parent_index(parent);
+                if (is_max_level(grandparent) ? less(grandparent, i) : less(i, grandparent))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    IdIndex _index;
+
+    std::vector<Node> _heap;
+
+    std::size_t _peak_size = 0;
+};
+
+} // namespace bs
@@ -0,0 +1,539 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "FlatIdIndex.hpp"
+#include "HeapConstIterator.hpp"
+#include "MemoryUsage.hpp"
+
+namespace bs
+{
+
+/// @brief A pairing heap with the interface of `AlterBinaryHeap`, which overwrites the `T` value
+/// if it is already in the heap, found by `T::unique_id()`.
+///
+/// `push()` and `increase_key()` are O(1), the rest is O(log n) amortized.
+/// It wins when priorities are raised a lot more often than the top is popped.
+///
+/// Nodes are stored contiguously and linked by index: the hole left by an erased node is filled with the last one.
+///
+/// @tparam T type of value to store
+/// @tparam Compare ordering of `T`
+/// @tparam UniqueIdHash hasher of `T::unique_id()`
+/// @tparam UniqueIdEqual equality check of `T::unique_id()`
+template <typename T, typename Compare = std::less<T>,
+          typename UniqueIdHash = std::hash<std::invoke_result_t<decltype(&T::unique_id), T>>,
+          typename UniqueIdEqual = std::equal_to<std::invoke_result_t<decltype(&T::unique_id), T>>>
+class AlterPairingHeap
+{
+public:
+    static_assert(std::is_member_function_pointer_v<decltype(&T::unique_id)>);
+
+    using UniqueId = std::invoke_result_t<decltype(&T::unique_id), T>;
+    /// pushes are free to go above the last popped value, unlike `AlterRadixHeap`
+    static constexpr bool MONOTONE = false;
+
+private:
+    using IdIndex = FlatIdIndex<UniqueId, UniqueIdHash, UniqueIdEqual>;
+    static constexpr std::size_t NPOS = IdIndex::NPOS;
+
+    struct Node
+    {
+        T value;
+        /// slot of `value.unique_id()` in `_index`
+        std::size_t slot;
+
+        /// leftmost child
+        std::size_t child = NPOS;
+        /// next sibling to the right
+        std::size_t sibling = NPOS;
+        /// parent if leftmost child, previous sibling otherwise, `NPOS` if root
+        std::size_t prev = NPOS;
+    };
+
+public:
+    /// @brief Random Access Iterator, in node array order
+    using ConstIterator = HeapConstIterator<T, Node>;
+
+public:
+    AlterPairingHeap() = default;
+
+    AlterPairingHeap(std::size_t reserve_size)
+    {
+        _index.reserve(reserve_size, on_slot_move());
+        _nodes.reserve(reserve_size);
+    }
+
+    /// @brief Builds the heap from a range, see `assign()`.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    AlterPairingHeap(InputIt first, Sentinel last)
+    {
+        assign(first, last);
+    }
+
+public: // Element access
+    auto top() const -> const T&
+    {
+        return _nodes[_root].value;
+    }
+
+public: // Capacity
+    bool empty() const
+    {
+        return _nodes.empty();
+    }
+
+    auto size() const -> std::size_t
+    {
+        return _nodes.size();
+    }
+
+public: // Memory
+    /// @brief `node_bytes` are the used part of the node array, `array_bytes` its unused capacity
+    /// and the melding scratch, and `bucket_bytes` the slots of the id index.
+    auto memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(size());
+    }
+
+    /// @brief Memory usage at the largest size since construction or the last `reset_peak()`.
+    /// The arrays never shrink, so their current size is their peak.
+    auto peak_memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(_peak_size);
+    }
+
+    void reset_peak()
+    {
+        _peak_size = size();
+    }
+
+public: // Modifiers
+    void push(const T& value)
+    {
+        push_impl(value);
+    }
+
+    void push(T&& value)
+    {
+        push_impl(std::move(value));
+    }
+
+    /// @brief Replaces the contents with a range, in O(n).
+    /// Values with the same `unique_id()` are deduplicated, the last one wins like successive `push()`es.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    void assign(InputIt first, Sentinel last)
+    {
+        _nodes.clear();
+        _index.clear();
+        _root = NPOS;
+
+        if constexpr (std::forward_iterator<InputIt>)
+        {
+            const auto count = static_cast<std::size_t>(std::ranges::distance(first, last));
+            _index.reserve(count, on_slot_move());
+            _nodes.reserve(count);
+        }
+
+        for (; first != last; ++first)
+            store(*first);
+
+        // meld in rounds of pairs, rather than one by one, so that the root doesn't end up with n - 1 children
+        _scratch.resize(size());
+        for (std::size_t i = 0; i < size(); ++i)
+            _scratch[i] = i;
+        _root = meld_rounds();
+    }
+
+    /// @brief Pushes every value of a range, like successive `push()`es.
+    template <std::ranges::input_range Range>
+    void push_many(Range&& values)
+    {
+        if constexpr (std::ranges::forward_range<Range>)
+        {
+            const auto count = static_cast<std::size_t>(std::ranges::distance(values));
+            _index.reserve(size() + count, on_slot_move());
+            _nodes.reserve(size() + count);
+        }
+
+        for (auto&& value : values)
+            push_impl(std::forward<decltype(value)>(value));
+    }
+
+    /// @brief Moves the top `k` values (all of them if fewer) to `out`, best first, like `k` times `top()` and `pop()`.
+    /// @return `out` past the last moved value
+    template <std::weakly_incrementable OutputIt>
+    auto pop_k(std::size_t k, OutputIt out) -> OutputIt
+    {
+        k = std::min(k, size());
+        for (; k > 0; --k)
+        {
+            *out = std::move(_nodes[_root].value);
+            ++out;
+            erase_at(_root);
+        }
+        return out;
+    }
+
+    void pop()
+    {
+        erase_at(_root);
+    }
+
+    /// @return whether `id` was found and erased
+    bool erase(const UniqueId& id)
+    {
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot == NPOS)
+            return false;
+
+        erase_at(_index.position(slot));
+        return true;
+    }
+
+    /// @brief Mutates the value of `id` in place with `fn(T&)`, and re-melds it.
+    /// `fn` must not change the `unique_id()`.
+    /// @return whether `id` was found
+    template <typename Fn>
+    bool modify(const UniqueId& id, Fn&& fn)
+    {
+        return modify_impl(id, std::forward<Fn>(fn), [this](std::size_t node) { reposition(node); });
+    }
+
+    /// @brief `modify()` where `fn(T&)` only moves the value towards the top, in O(1):
+    /// its subtree is cut and melded with the root.
+    template <typename Fn>
+    bool increase_key(const UniqueId& id, Fn&& fn)
+    {
+        return modify_impl(id, std::forward<Fn>(fn), [this](std::size_t node) {
+            if (node != _root)
+            {
+                cut(node);
+                _root = meld(_root, node);
+            }
+        });
+    }
+
+    /// @brief `modify()` where `fn(T&)` only moves the value away from the top.
+    template <typename Fn>
+    bool decrease_key(const UniqueId& id, Fn&& fn)
+    {
+        return modify_impl(id, std::forward<Fn>(fn), [this](std::size_t node) { reposition(node); });
+    }
+
+public: // Iterators
+    auto cbegin() const noexcept -> ConstIterator
+    {
+        return ConstIterator(_nodes, 0);
+    }
+
+    auto begin() const noexcept -> ConstIterator
+    {
+        return cbegin();
+    }
+
+    auto cend() const noexcept -> ConstIterator
+    {
+        return ConstIterator(_nodes, size());
+    }
+
+    auto end() const noexcept -> ConstIterator
+    {
+        return cend();
+    }
+
+public: // Lookup
+    auto find(const UniqueId& id) const -> ConstIterator
+    {
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot != NPOS)
+            return ConstIterator(_nodes, _index.position(slot));
+
+        return cend();
+    }
+
+private:
+    template <typename TVal>
+    void push_impl(TVal&& val)
+    {
+        const auto [node, inserted] = store(std::forward<TVal>(val));
+
+        if (inserted)
+            _root = meld(_root, node);
+        else
+            reposition(node);
+    }
+
+    /// @brief Overwrites the value with the same id, or appends an unlinked node, without restoring the heap.
+    /// @return node index of the value, and whether it was appended
+    template <typename TVal>
+    auto store(TVal&& val) -> std::pair<std::size_t, bool>
+    {
+        const auto uid = val.unique_id();
+        const std::size_t slot = _index.find(uid, id_of());
+
+        if (slot != NPOS)
+        {
+            const std::size_t node = _index.position(slot);
+            _nodes[node].value = std::forward<TVal>(val);
+            return {node, false};
+        }
+
+        const std::size_t node = size();
+        const std::size_t new_slot = _index.insert(uid, node, on_slot_move());
+        _nodes.push_back(Node{.value = T(std::forward<TVal>(val)), .slot = new_slot});
+        _peak_size = std::max(_peak_size, size());
+
+        return {node, true};
+    }
+
+    template <typename Fn, typename Resift>
+    bool modify_impl(const UniqueId& id, Fn&& fn, Resift resift)
+    {
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot == NPOS)
+            return false;
+
+        const std::size_t node = _index.position(slot);
+        std::invoke(std::forward<Fn>(fn), _nodes[node].value);
+        assert(UniqueIdEqual{}(_nodes[node].value.unique_id(), id) && "`fn` changed the unique id");
+
+        resift(node);
+        return true;
+    }
+
+    void erase_at(std::size_t node)
+    {
+        assert(node < size());
+
+        const std::size_t children = merge_children(node);
+        if (node == _root)
+            _root = children;
+        else
+        {
+            cut(node);
+            _root = meld(_root, children);
+        }
+
+        _index.erase(_nodes[node].slot, on_slot_move());
+        fill_hole(node);
+    }
+
+private:
+    /// @brief Moves the last node to the unlinked `hole`, and shrinks the node array.
+    void fill_hole(std::size_t hole)
+    {
+        const std::size_t last = size() - 1;
+        if (hole != last)
+        {
+            _nodes[hole] = std::move(_nodes[last]);
+
+            const Node& moved = _nodes[hole];
+            if (moved.prev != NPOS)
+            {
+                Node& prev = _nodes[moved.prev];
+                (prev.child == last ? prev.child : prev.sibling) = hole;
+            }
+            if (moved.sibling != NPOS)
+                _nodes[moved.sibling].prev = hole;
+            if (moved.child != NPOS)
+                _nodes[moved.child].prev = hole;
+            if (_root == last)
+                _root = hole;
+
+            _index.position(moved.slot) = hole;
+        }
+
+        _nodes.pop_back();
+    }
+
+    /// @brief Re-melds a node whose value moved in either direction.
+    void reposition(std::size_t node)
+    {
+        const std::size_t children = merge_children(node);
+        if (node != _root)
+        {
+            cut(node);
+            _root = meld(_root, node);
+        }
+        _root = meld(_root, children);
+    }
+
+    /// @brief Detaches the subtree of a non-root node.
+    void cut(std::size_t node)
+    {
+        Node& cur = _nodes[node];
+        assert(cur.prev != NPOS);
+
+        Node& prev = _nodes[cur.prev];
+        (prev.child == node ? prev.child : prev.sibling) = cur.sibling;
+        if (cur.sibling != NPOS)
+            _nodes[cur.sibling].prev = cur.prev;
+
+        cur.prev = NPOS;
+        cur.sibling = NPOS;
+    }
+
+    /// @brief Melds two roots, `NPOS` being an empty heap.
+    /// @return the new root
+    auto meld(std::size_t left, std::size_t right) -> std::size_t
+    {
+        if (left == NPOS)
+            return right;
+        if (right == NPOS)
+            return left;
+
+        if (Compare{}(_nodes[left].value, _nodes[right].value))
+            std::swap(left, right);
+
+        Node& parent = _nodes[left];
+        Node& child = _nodes[right];
+        child.sibling = parent.child;
+        if (parent.child != NPOS)
+            _nodes[parent.child].prev = right;
+        child.prev = left;
+        parent.child = right;
+
+        return left;
+    }
+
+    /// @brief Detaches the children of `node` and melds them with the two-pass pairing.
+    /// @return root of the melded children, `NPOS` if none
+    auto merge_children(std::size_t node) -> std::size_t
+    {
+        std::size_t cur = std::exchange(_nodes[node].child, NPOS);
+
+        _scratch.clear();
+        while (cur != NPOS)
+        {
+            const std::size_t next = _nodes[cur].sibling;
+            _nodes[cur].prev = NPOS;
+            _nodes[cur].sibling = NPOS;
+            _scratch.push_back(cur);
+            cur = next;
+        }
+
+        if (_scratch.empty())
+            return NPOS;
+
+        // first pass: meld pairs left to right
+        std::size_t pairs = 0;
+        for (std::size_t i = 0; i < _scratch.size(); i += 2)
+            _scratch[pairs++] = (i + 1 < _scratch.size()) ? meld(_scratch[i], _scratch[i + 1]) : _scratch[i];
+
+        // second pass: meld the pairs right to left
+        std::size_t root = _scratch[pairs - 1];
+        for (std::size_t i = pairs - 1; i-- > 0;)
+            root = meld(_scratch[i], root);
+
+        return root;
+    }
+
+    /// @brief Melds the unlinked roots in `_scratch` pairwise in rounds, in O(n).
+    /// @return the new root, `NPOS` if none
+    auto meld_rounds() -> std::size_t
+    {
+        if (_scratch.empty())
+            return NPOS;
+
+        for (std::size_t count = _scratch.size(); count > 1;)
+        {
+            std::size_t melded = 0;
+            for (std::size_t i = 0; i < count; i += 2)
+                _scratch[melded++] = (i + 1 < count) ? meld(_scratch[i], _scratch[i + 1]) : _scratch[i];
+            count = melded;
+        }
+
+        return _scratch.front();
+    }
+
+private:
+    auto memory_usage_of(std::size_t node_count) const -> MemoryUsage
+    {
+        constexpr std::size_t MEMBER_BYTES = sizeof(T) + 4 * sizeof(std::size_t);
+        const std::size_t capacity = std::max(node_count, _nodes.capacity());
+        const std::size_t scratch_bytes = _scratch.capacity() * sizeof(std::size_t);
+
+        return MemoryUsage{
+            .node_count = node_count,
+            .node_bytes = node_count * sizeof(Node),
+            .padding_bytes = node_count * (sizeof(Node) - MEMBER_BYTES),
+            .overhead_bytes = allocation_overhead(capacity * sizeof(Node)) + allocation_overhead(scratch_bytes) +
+                              allocation_overhead(_index.memory_bytes()) + sizeof(*this),
+            .bucket_bytes = _index.memory_bytes(),
+            .array_bytes = (capacity - node_count) * sizeof(Node) + scratch_bytes,
+        };
+    }
+
+private:
+    /// @brief Reads the id at a node index, for `FlatIdIndex`
+    auto id_of() const
+    {
+        return [this](std::size_t node) -> decltype(auto) { return _nodes[node].value.unique_id(); };
+    }
+
+    /// @brief Follows the slot moves of `FlatIdIndex`
+    auto on_slot_move()
+    {
+        return [this](std::size_t node, std::size_t slot) { _nodes[node].slot = slot; };
+    }
+
+public:
+    bool validate() const
+    {
+        if (_index.size() != size())
+            return false;
+        for (std::size_t i = 0; i < size(); ++i)
+            if (_index.position(_nodes[i].slot) != i)
+                return false;
+
+        if (empty())
+            return _root == NPOS;
+        if (_root >= size() || _nodes[_root].prev != NPOS || _nodes[_root].sibling != NPOS)
+            return false;
+
+        // every node is reached once from the root, with consistent back links, and isn't below its children
+        std::size_t reached = 1;
+        std::vector<std::size_t> stack{_root};
+        while (!stack.empty())
+        {
+            const std::size_t parent = stack.back();
+            stack.pop_back();
+
+            std::size_t prev = parent;
+            for (std::size_t child = _nodes[parent].child; child != NPOS; child = _nodes[child].sibling)
+            {
+                if (child >= size() || _nodes[child].prev != prev || reached >= size())
+                    return false;
+                if (Compare{}(_nodes[parent].value, _nodes[child].value))
+                    return false;
+
+                reached += 1;
+                stack.push_back(child);
+                prev = child;
+            }
+        }
+        return reached == size();
+    }
+
+private:
+    IdIndex _index;
+
+    std::vector<Node> _nodes;
+    std::size_t _root = NPOS;
+
+    /// roots to be melded, kept to avoid allocating on every `pop()`
+    std::vector<std::size_t> _scratch;
+
+    std::size_t _peak_size = 0;
+};
+
+} // namespace bs
@@ -0,0 +1,485 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <ranges>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "FlatIdIndex.hpp"
+#include "HeapConstIterator.hpp"
+#include "MemoryUsage.hpp"
+
+namespace bs
+{
+
+/// @brief A radix heap with the interface of `AlterBinaryHeap`, which overwrites the `T` value
+/// if it is already in the heap, found by `T::unique_id()`.
+///
+/// It's ordered by an unsigned integer priority, `PriorityOf{}(value)`, the largest on top like `std::less`.
+/// It's monotone: a pushed or modified priority must not be above the last popped one, as in Dijkstra's algorithm
+/// (with reversed distances). Then every operation but `pop()` is O(1), and `pop()` is O(log C) amortized,
+/// where C is the range of the priorities.
+///
+/// Nodes are stored contiguously, in buckets by the highest bit differing from the last popped priority.
+///
+/// @tparam T type of value to store
+/// @tparam PriorityOf gets the unsigned integer priority of a `T`
+/// @tparam UniqueIdHash hasher of `T::unique_id()`
+/// @tparam UniqueIdEqual equality check of `T::unique_id()`
+template <typename T, typename PriorityOf,
+          typename UniqueIdHash = std::hash<std::invoke_result_t<decltype(&T::unique_id), T>>,
+          typename UniqueIdEqual = std::equal_to<std::invoke_result_t<decltype(&T::unique_id), T>>>
+class AlterRadixHeap
+{
+public:
+    static_assert(std::is_member_function_pointer_v<decltype(&T::unique_id)>);
+
+    using UniqueId = std::invoke_result_t<decltype(&T::unique_id), T>;
+    using Priority = std::remove_cvref_t<std::invoke_result_t<PriorityOf, const T&>>;
+    static_assert(std::unsigned_integral<Priority> && std::numeric_limits<Priority>::digits <= 64);
+
+    /// pushed priorities must not be above the last popped one
+    static constexpr bool MONOTONE = true;
+
+private:
+    using IdIndex = FlatIdIndex<UniqueId, UniqueIdHash, UniqueIdEqual>;
+    static constexpr std::size_t NPOS = IdIndex::NPOS;
+
+    /// bucket 0 holds the keys equal to the last popped one, bucket `b` the ones whose highest differing bit is `b - 1`
+    static constexpr std::size_t BUCKET_COUNT = std::numeric_limits<Priority>::digits + 1;
+
+    struct Node
+    {
+        T value;
+        /// slot of `value.unique_id()` in `_index`
+        std::size_t slot;
+
+        /// position in `_buckets[bucket]`
+        std::size_t bucket_pos;
+        std::uint8_t bucket;
+    };
+
+public:
+    /// @brief Random Access Iterator, in node array order
+    using ConstIterator = HeapConstIterator<T, Node>;
+
+public:
+    AlterRadixHeap() = default;
+
+    AlterRadixHeap(std::size_t reserve_size)
+    {
+        _index.reserve(reserve_size, on_slot_move());
+        _nodes.reserve(reserve_size);
+    }
+
+    /// @brief Builds the heap from a range, see `assign()`.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    AlterRadixHeap(InputIt first, Sentinel last)
+    {
+        assign(first, last);
+    }
+
+public: // Element access
+    /// @note O(1) right after a `pop()`, otherwise it may scan the smallest non-empty bucket.
+    auto top() const -> const T&
+    {
+        return _nodes[top_node()].value;
+    }
+
+public: // Capacity
+    bool empty() const
+    {
+        return _nodes.empty();
+    }
+
+    auto size() const -> std::size_t
+    {
+        return _nodes.size();
+    }
+
+public: // Memory
+    /// @brief `node_bytes` are the used part of the node array, `array_bytes` its unused capacity,
+    /// and `bucket_bytes` the radix buckets and the slots of the id index.
+    auto memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(size());
+    }
+
+    /// @brief Memory usage at the largest size since construction or the last `reset_peak()`.
+    /// The arrays never shrink, so their current size is their peak.
+    auto peak_memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(_peak_size);
+    }
+
+    void reset_peak()
+    {
+        _peak_size = size();
+    }
+
+public: // Modifiers
+    void push(const T& value)
+    {
+        push_impl(value);
+    }
+
+    void push(T&& value)
+    {
+        push_impl(std::move(value));
+    }
+
+    /// @brief Replaces the contents with a range, in O(n), and forgets the last popped priority.
+    /// Values with the same `unique_id()` are deduplicated, the last one wins like successive `push()`es.
+    template <std::input_iterator InputIt, std::sentinel_for<InputIt> Sentinel>
+    void assign(InputIt first, Sentinel last)
+    {
+        _nodes.clear();
+        _index.clear();
+        for (auto& bucket : _buckets)
+            bucket.clear();
+        _last_key = 0;
+
+        if constexpr (std::forward_iterator<InputIt>)
+        {
+            const auto count = static_cast<std::size_t>(std::ranges::distance(first, last));
+            _index.reserve(count, on_slot_move());
+            _nodes.reserve(count);
+        }
+
+        for (; first != last; ++first)
+            store(*first);
+
+        for (std::size_t node = 0; node < size(); ++node)
+            bucket_insert(node);
+    }
+
+    /// @brief Pushes every value of a range, like successive `push()`es.
+    template <std::ranges::input_range Range>
+    void push_many(Range&& values)
+    {
+        if constexpr (std::ranges::forward_range<Range>)
+        {
+            const auto count = static_cast<std::size_t>(std::ranges::distance(values));
+            _index.reserve(size() + count, on_slot_move());
+            _nodes.reserve(size() + count);
+        }
+
+        for (auto&& value : values)
+            push_impl(std::forward<decltype(value)>(value));
+    }
+
+    /// @brief Moves the top `k` values (all of them if fewer) to `out`, best first, like `k` times `top()` and `pop()`.
+    /// @return `out` past the last moved value
+    template <std::weakly_incrementable OutputIt>
+    auto pop_k(std::size_t k, OutputIt out) -> OutputIt
+    {
+        k = std::min(k, size());
+        for (; k > 0; --k)
+        {
+            if (_buckets[0].empty())
+                redistribute();
+
+            const std::size_t node = _buckets[0].back();
+            *out = std::move(_nodes[node].value);
+            ++out;
+            erase_at(node);
+        }
+        return out;
+    }
+
+    void pop()
+    {
+        assert(!empty());
+
+        if (_buckets[0].empty())
+            redistribute();
+
+        erase_at(_buckets[0].back());
+    }
+
+    /// @return whether `id` was found and erased
+    bool erase(const UniqueId& id)
+    {
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot == NPOS)
+            return false;
+
+        erase_at(_index.position(slot));
+        return true;
+    }
+
+    /// @brief Mutates the value of `id` in place with `fn(T&)`, and moves it to its new bucket.
+    /// `fn` must not change the `unique_id()`, nor raise the priority above the last popped one.
+    /// @return whether `id` was found
+    template <typename Fn>
+    bool modify(const UniqueId& id, Fn&& fn)
+    {
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot == NPOS)
+            return false;
+
+        const std::size_t node = _index.position(slot);
+        bucket_erase(node);
+        std::invoke(std::forward<Fn>(fn), _nodes[node].value);
+        assert(UniqueIdEqual{}(_nodes[node].value.unique_id(), id) && "`fn` changed the unique id");
+        bucket_insert(node);
+
+        return true;
+    }
+
+    /// @brief Same as `modify()`, both directions take O(1).
+    template <typename Fn>
+    bool increase_key(const UniqueId& id, Fn&& fn)
+    {
+        return modify(id, std::forward<Fn>(fn));
+    }
+
+    /// @brief Same as `modify()`, both directions take O(1).
+    template <typename Fn>
+    bool decrease_key(const UniqueId& id, Fn&& fn)
+    {
+        return modify(id, std::forward<Fn>(fn));
+    }
+
+public: // Iterators
+    auto cbegin() const noexcept -> ConstIterator
+    {
+        return ConstIterator(_nodes, 0);
+    }
+
+    auto begin() const noexcept -> ConstIterator
+    {
+        return cbegin();
+    }
+
+    auto cend() const noexcept -> ConstIterator
+    {
+        return ConstIterator(_nodes, size());
+    }
+
+    auto end() const noexcept -> ConstIterator
+    {
+        return cend();
+    }
+
+public: // Lookup
+    auto find(const UniqueId& id) const -> ConstIterator
+    {
+        const std::size_t slot = _index.find(id, id_of());
+        if (slot != NPOS)
+            return ConstIterator(_nodes, _index.position(slot));
+
+        return cend();
+    }
+
+private:
+    template <typename TVal>
+    void push_impl(TVal&& val)
+    {
+        const auto [node, inserted] = store(std::forward<TVal>(val));
+
+        if (!inserted)
+            bucket_erase(node);
+        bucket_insert(node);
+    }
+
+    /// @brief Overwrites the value with the same id, or appends it to the node array, without touching the buckets.
+    /// @return node index of the value, and whether it was appended
+    template <typename TVal>
+    auto store(TVal&& val) -> std::pair<std::size_t, bool>
+    {
+        const auto uid = val.unique_id();
+        const std::size_t slot = _index.find(uid, id_of());
+
+        if (slot != NPOS)
+        {
+            const std::size_t node = _index.position(slot);
+            _nodes[node].value = std::forward<TVal>(val);
+            return {node, false};
+        }
+
+        const std::size_t node = size();
+        const std::size_t new_slot = _index.insert(uid, node, on_slot_move());
+        _nodes.push_back(Node{.value = T(std::forward<TVal>(val)), .slot = new_slot, .bucket_pos = 0, .bucket = 0});
+        _peak_size = std::max(_peak_size, size());
+
+        return {node, true};
+    }
+
+    void erase_at(std::size_t node)
+    {
+        assert(node < size());
+
+        bucket_erase(node);
+        _index.erase(_nodes[node].slot, on_slot_move());
+
+        // fill the hole with the last node
+        const std::size_t last = size() - 1;
+        if (node != last)
+        {
+            _nodes[node] = std::move(_nodes[last]);
+            _buckets[_nodes[node].bucket][_nodes[node].bucket_pos] = node;
+            _index.position(_nodes[node].slot) = node;
+        }
+        _nodes.pop_back();
+    }
+
+private:
+    /// @brief Empties the smallest non-empty bucket into the lower ones, around its smallest key,
+    /// which becomes the last popped key.
+    void redistribute()
+    {
+        const std::size_t bucket = first_bucket();
+        assert(bucket != 0 && bucket < BUCKET_COUNT);
+
+        std::vector<std::size_t>& nodes = _buckets[bucket];
+        _last_key = key_of(*std::ranges::min_element(nodes, {}, [this](std::size_t node) { return key_of(node); }));
+
+        // every key of `bucket` shares the bits above `bucket - 1` with the new `_last_key`, so lands lower
+        _scratch.swap(nodes);
+        for (const std::size_t node : _scratch)
+            bucket_insert(node);
+        _scratch.clear();
+    }
+
+    void bucket_insert(std::size_t node)
+    {
+        const Priority key = key_of(node);
+        assert(key >= _last_key && "priority above the last popped one");
+
+        const auto bucket = static_cast<std::uint8_t>(bucket_of(key));
+        _nodes[node].bucket = bucket;
+        _nodes[node].bucket_pos = _buckets[bucket].size();
+        _buckets[bucket].push_back(node);
+    }
+
+    void bucket_erase(std::size_t node)
+    {
+        std::vector<std::size_t>& nodes = _buckets[_nodes[node].bucket];
+        const std::size_t pos = _nodes[node].bucket_pos;
+
+        nodes[pos] = nodes.back();
+        _nodes[nodes[pos]].bucket_pos = pos;
+        nodes.pop_back();
+    }
+
+    auto bucket_of(Priority key) const -> std::size_t
+    {
+        return static_cast<std::size_t>(std::bit_width(static_cast<Priority>(key ^ _last_key)));
+    }
+
+    auto first_bucket() const -> std::size_t
+    {
+        std::size_t bucket = 0;
+        while (bucket < BUCKET_COUNT && _buckets[bucket].empty())
+            ++bucket;
+        return bucket;
+    }
+
+    auto top_node() const -> std::size_t
+    {
+        assert(!empty());
+
+        const std::vector<std::size_t>& nodes = _buckets[first_bucket()];
+        return *std::ranges::min_element(nodes, {}, [this](std::size_t node) { return key_of(node); });
+    }
+
+    /// @brief Radix key, the bitwise not of the priority, so that the largest priority has the smallest key
+    auto key_of(std::size_t node) const -> Priority
+    {
+        return static_cast<Priority>(~PriorityOf{}(_nodes[node].value));
+    }
+
+private:
+    auto memory_usage_of(std::size_t node_count) const -> MemoryUsage
+    {
+        constexpr std::size_t MEMBER_BYTES = sizeof(T) + 2 * sizeof(std::size_t) + sizeof(std::uint8_t);
+        const std::size_t capacity = std::max(node_count, _nodes.capacity());
+
+        const std::size_t scratch_bytes = _scratch.capacity() * sizeof(std::size_t);
+
+        std::size_t bucket_bytes = _index.memory_bytes() + scratch_bytes;
+        std::size_t overhead_bytes = allocation_overhead(capacity * sizeof(Node)) +
+                                     allocation_overhead(_index.memory_bytes()) + allocation_overhead(scratch_bytes) +
+                                     sizeof(*this);
+        for (const auto& bucket : _buckets)
+        {
+            bucket_bytes += bucket.capacity() * sizeof(std::size_t);
+            overhead_bytes += allocation_overhead(bucket.capacity() * sizeof(std::size_t));
+        }
+
+        return MemoryUsage{
+            .node_count = node_count,
+            .node_bytes = node_count * sizeof(Node),
+            .padding_bytes = node_count * (sizeof(Node) - MEMBER_BYTES),
+            .overhead_bytes = overhead_bytes,
+            .bucket_bytes = bucket_bytes,
+            .array_bytes = (capacity - node_count) * sizeof(Node),
+        };
+    }
+
+private:
+    /// @brief Reads the id at a node index, for `FlatIdIndex`
+    auto id_of() const
+    {
+        return [this](std::size_t node) -> decltype(auto) { return _nodes[node].value.unique_id(); };
+    }
+
+    /// @brief Follows the slot moves of `FlatIdIndex`
+    auto on_slot_move()
+    {
+        return [this](std::size_t node, std::size_t slot) { _nodes[node].slot = slot; };
+    }
+
+public:
+    bool validate() const
+    {
+        if (_index.size() != size())
+            return false;
+        for (std::size_t i = 0; i < size(); ++i)
+            if (_index.position(_nodes[i].slot) != i)
+                return false;
+
+        std::size_t bucketed = 0;
+        for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket)
+        {
+            for (std::size_t pos = 0; pos < _buckets[bucket].size(); ++pos)
+            {
+                const std::size_t node = _buckets[bucket][pos];
+                if (node >= size() || _nodes[node].bucket != bucket || _nodes[node].bucket_pos != pos)
+                    return false;
+
+                const Priority key = key_of(node);
+                if (key < _last_key || bucket_of(key) != bucket)
+                    return false;
+            }
+            bucketed += _buckets[bucket].size();
+        }
+        return bucketed == size();
+    }
+
+private:
+    IdIndex _index;
+
+    std::vector<Node> _nodes;
+    std::array<std::vector<std::size_t>, BUCKET_COUNT> _buckets;
+    /// radix key of the last popped value
+    Priority _last_key = 0;
+
+    /// bucket being redistributed, kept to avoid allocating on every `pop()`
+    std::vector<std::size_t> _scratch;
+
+    std::size_t _peak_size = 0;
+};
+
+} // namespace bs
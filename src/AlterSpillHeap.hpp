@@ -0,0 +1,994 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "AlterBinaryHeap.hpp"
+#include "FlatIdIndex.hpp"
+#include "MemoryUsage.hpp"
+
+namespace bs
+{
+
+/// @brief A heap which overwrites the `T` value with the same `T::unique_id()`, like `AlterBinaryHeap`,
+/// for more values than fit in memory.
+///
+/// New values go to a hot in-memory `AlterBinaryHeap`. Once it's full, it's flushed to the spill directory
+/// as a run file: its values best first, then the same ones by id hash, where the ids are looked up.
+/// `top()` and `pop()` merge the hot heap with the heads of the runs, which are read block by block.
+///
+/// Runs are merged by levels: spilled runs are of level 0, and `RUNS_PER_LEVEL` runs of a level are merged
+/// into one of the next level. So each value is rewritten O(log(n / hot_capacity)) times,
+/// and past `MAX_RUNS` runs, the lowest levels are merged together as well.
+///
+/// Runs aren't rewritten in place: the values before the head of a run were popped, and overwriting
+/// or erasing a spilled value adds a tombstone, a copy of it which sorts right before it in both orders.
+/// The tombstones are spilled along with the hot heap, and the merges drop them along with their values,
+/// as do the pops, which meet the two in a row. So the memory is the hot heap and the tombstones not spilled
+/// yet, which share `hot_capacity`, plus a block per run and a fence per `INDEX_BLOCK` spilled values.
+/// In exchange, `contains()`, `erase()` and pushing an id which isn't hot read a block of each run.
+///
+/// Failing to write or read a run throws `std::runtime_error`, and leaves the values as they were:
+/// the hot heap is spilled before a push rather than after it, a run only replaces the values it's made of
+/// once it's complete, and the runs are only moved past the popped records once their blocks are read.
+/// A failed merge is retried by the next spill.
+///
+/// Values on disk can't be referred to, so there are no iterators, `find()` nor `modify()`:
+/// push the new value instead. As the lookups read the run files,
+/// even the const member functions can't be called concurrently.
+///
+/// @tparam T type of value to store, trivially copyable as it's written to files as is
+/// @tparam Compare ordering of `T`
+/// @tparam UniqueIdHash hasher of `T::unique_id()`
+/// @tparam UniqueIdEqual equality check of `T::unique_id()`
+template <typename T, typename Compare = std::less<T>,
+          typename UniqueIdHash = std::hash<std::invoke_result_t<decltype(&T::unique_id), T>>,
+          typename UniqueIdEqual = std::equal_to<std::invoke_result_t<decltype(&T::unique_id), T>>>
+class AlterSpillHeap
+{
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "`T` is spilled to files as is");
+
+    using UniqueId = std::invoke_result_t<decltype(&T::unique_id), T>;
+    using HotHeap = AlterBinaryHeap<T, Compare, UniqueIdHash, UniqueIdEqual>;
+
+    /// runs of a level merged into one of the next level
+    static constexpr std::size_t RUNS_PER_LEVEL = 4;
+    /// lowest levels merged together past this count, which bounds the open files and the read buffers
+    static constexpr std::size_t MAX_RUNS = 32;
+    /// values read from or written to a run at once
+    static constexpr std::size_t RUN_BLOCK = 4096;
+    /// values of the id section of a run read by a lookup, which a fence in memory points to
+    static constexpr std::size_t INDEX_BLOCK = 256;
+
+private:
+    struct Record
+    {
+        T value;
+        /// `version * 2 + 1` for a value, `version * 2` for the tombstone of the value of `version`,
+        /// unique to the value, which also breaks the priority ties of the runs
+        std::uint64_t stamp;
+    };
+
+    /// @brief Records `[position, end)` of a run file, read a block at a time.
+    struct Reader
+    {
+        std::filesystem::path path;
+        std::ifstream file;
+        std::vector<Record> block;
+        std::size_t next = 0;
+        /// record of the file following `block`
+        std::size_t position = 0;
+        std::size_t end = 0;
+        /// head of the run, when reading its id section: the records before it were popped
+        std::optional<Record> run_head;
+
+        auto head() const -> const Record&
+        {
+            return block[next];
+        }
+    };
+
+    /// @brief What the lookups keep in memory of the id section of a run.
+    struct Index
+    {
+        /// id hash of the first record of each `INDEX_BLOCK`
+        std::vector<std::size_t> fences;
+        /// id hash of the last record, past which the lookups skip the run, as the new ids often are
+        std::size_t last_hash = 0;
+    };
+
+    /// @brief Run file of `count` records best first, then the same ones by id hash.
+    /// Its reader is at its head, past the popped records.
+    struct Run
+    {
+        Reader reader;
+        std::size_t count = 0;
+        Index index;
+        /// 0 if spilled, higher once merged, see `compact()`
+        std::size_t level = 0;
+
+        auto head() const -> const Record&
+        {
+            return reader.head();
+        }
+    };
+
+    /// @brief Tombstone of an overwritten or erased spilled value, not spilled yet.
+    struct Tombstone
+    {
+        Record record;
+        /// slot of the stamp in `_tombstone_index`
+        std::size_t slot;
+    };
+
+    /// @brief Position of the reader of a run, which `settle()` moves before the run.
+    struct Cursor
+    {
+        /// read aside if `aside`, the block of the reader otherwise
+        std::vector<Record> block;
+        bool aside = false;
+        std::size_t next = 0;
+        std::size_t position = 0;
+    };
+
+public:
+    /// @param hot_capacity values kept in memory before being spilled
+    /// @param directory where the run files go, which should exist
+    /// @throw std::invalid_argument if `hot_capacity` is 0
+    AlterSpillHeap(std::size_t hot_capacity,
+                   std::filesystem::path directory = std::filesystem::temp_directory_path())
+        : _hot(hot_capacity), _hot_capacity(hot_capacity), _directory(std::move(directory))
+    {
+        if (hot_capacity == 0)
+            throw std::invalid_argument("AlterSpillHeap needs a hot capacity of at least 1");
+
+        std::random_device rd;
+        _file_prefix = "alter-spill-" + std::to_string(rd()) + "-" + std::to_string(rd());
+    }
+
+    // the run files belong to a single heap
+    AlterSpillHeap(const AlterSpillHeap&) = delete;
+    AlterSpillHeap& operator=(const AlterSpillHeap&) = delete;
+
+    ~AlterSpillHeap()
+    {
+        for (const std::unique_ptr<Run>& run : _runs)
+            remove_file(*run);
+    }
+
+public: // Element access
+    auto top() const -> const T&
+    {
+        return top_is_hot() ? _hot.top() : _runs.front()->head().value;
+    }
+
+public: // Capacity
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    auto size() const -> std::size_t
+    {
+        return _size;
+    }
+
+    auto hot_capacity() const -> std::size_t
+    {
+        return _hot_capacity;
+    }
+
+    /// @brief Number of values in memory, the others are spilled.
+    auto hot_size() const -> std::size_t
+    {
+        return _hot.size();
+    }
+
+    auto run_count() const -> std::size_t
+    {
+        return _runs.size();
+    }
+
+    /// @brief Number of tombstones in memory, which are spilled along with the hot heap.
+    auto tombstone_count() const -> std::size_t
+    {
+        return _tombstones.size();
+    }
+
+public: // Memory
+    /// @brief Memory of the hot heap, plus the tombstones in `bucket_bytes`
+    /// and the read blocks & fences of the runs in `array_bytes`.
+    auto memory_usage() const -> MemoryUsage
+    {
+        MemoryUsage usage = _hot.memory_usage();
+        const std::size_t tombstone_bytes = _tombstones.capacity() * sizeof(Tombstone);
+        const std::size_t run_bytes = _runs.capacity() * sizeof(std::unique_ptr<Run>);
+
+        usage.bucket_bytes += _tombstone_index.memory_bytes() + tombstone_bytes;
+        usage.array_bytes += run_bytes;
+        usage.overhead_bytes += allocation_overhead(_tombstone_index.memory_bytes()) +
+                                allocation_overhead(tombstone_bytes) + allocation_overhead(run_bytes) +
+                                sizeof(*this) - sizeof(_hot);
+        for (const std::unique_ptr<Run>& run : _runs)
+        {
+            const std::size_t block_bytes = run->reader.block.capacity() * sizeof(Record);
+            const std::size_t fence_bytes = run->index.fences.capacity() * sizeof(std::size_t);
+            usage.array_bytes += block_bytes + fence_bytes;
+            usage.overhead_bytes += allocation_overhead(block_bytes) + allocation_overhead(fence_bytes) +
+                                    allocation_overhead(sizeof(Run));
+        }
+        return usage;
+    }
+
+public: // Modifiers
+    void push(const T& value)
+    {
+        push_impl(value);
+    }
+
+    void push(T&& value)
+    {
+        push_impl(std::move(value));
+    }
+
+    void pop()
+    {
+        assert(!empty());
+
+        if (top_is_hot())
+            _hot.pop();
+        else
+            settle(true);
+        _size -= 1;
+    }
+
+    /// @return whether `id` was found and erased
+    bool erase(const UniqueId& id)
+    {
+        if (!_hot.erase(id))
+        {
+            const std::optional<Record> spilled = find_spilled(id);
+            if (!spilled)
+                return false;
+            make_room(1);
+            tombstone(*spilled);
+        }
+        _size -= 1;
+        return true;
+    }
+
+public: // Lookup
+    bool contains(const UniqueId& id) const
+    {
+        return _hot.find(id) != _hot.cend() || find_spilled(id).has_value();
+    }
+
+private:
+    template <typename TVal>
+    void push_impl(TVal&& val)
+    {
+        const UniqueId uid = val.unique_id();
+        if (_hot.find(uid) != _hot.cend())
+        {
+            _hot.push(std::forward<TVal>(val));
+            return;
+        }
+
+        // the spilled value stays put through a spill, as only its tombstone or a pop would drop it
+        const std::optional<Record> spilled = find_spilled(uid);
+        // before the value goes in, so that a failure leaves the heap without it
+        make_room(spilled ? 2 : 1);
+        _hot.push(std::forward<TVal>(val));
+        if (spilled)
+        {
+            try
+            {
+                tombstone(*spilled);
+            }
+            catch (...)
+            {
+                _hot.erase(uid);
+                throw;
+            }
+        }
+        else
+            _size += 1;
+    }
+
+    /// @brief Spills the hot heap and the tombstones in memory if `count` more of them wouldn't fit.
+    void make_room(std::size_t count)
+    {
+        const std::size_t used = _hot.size() + _tombstones.size();
+        if (used > 0 && used + count > _hot_capacity)
+            spill();
+    }
+
+    /// @brief Flushes the hot heap and the tombstones in memory as a new run, then merges the full levels.
+    /// They're only cleared once the run is complete.
+    ///
+    /// The front run stays the same or gets a live head: a value tombstoned in memory isn't the head
+    /// of the front run, see `settle()`, so the records before its tombstone are before the front too.
+    void spill()
+    {
+        std::vector<Record> records;
+        records.reserve(_hot.size() + _tombstones.size());
+        std::uint64_t version = _last_version;
+        for (const T& value : _hot)
+            records.push_back(Record{.value = value, .stamp = ++version * 2 + 1});
+        for (const Tombstone& tombstone : _tombstones)
+            records.push_back(tombstone.record);
+        std::ranges::sort(records, precedes);
+
+        std::vector<Record> by_id = records;
+        std::ranges::sort(by_id, id_less);
+        Index index{.fences = {}, .last_hash = hash_of(by_id.back())};
+        for (std::size_t i = 0; i < by_id.size(); i += INDEX_BLOCK)
+            index.fences.push_back(hash_of(by_id[i]));
+
+        const std::filesystem::path path = next_run_path();
+        try
+        {
+            std::ofstream out = open_out(path);
+            write_records(out, path, records);
+            write_records(out, path, by_id);
+            close_out(out, path);
+            add_run(open_run(path, records.size(), 0, std::move(index)));
+        }
+        catch (...)
+        {
+            remove_path(path);
+            throw;
+        }
+
+        _last_version = version;
+        _hot.clear();
+        _tombstones.clear();
+        _tombstone_index.clear();
+
+        compact();
+    }
+
+    /// @brief Merges every level with `RUNS_PER_LEVEL` runs into the next one, from the lowest,
+    /// then the two lowest levels together while there are more than `MAX_RUNS` runs.
+    void compact()
+    {
+        for (std::size_t level = 0; level <= max_level(); ++level)
+        {
+            const std::vector<std::size_t> sources = runs_of_levels(level, level);
+            if (sources.size() >= RUNS_PER_LEVEL)
+                merge(sources, level + 1);
+        }
+
+        while (_runs.size() > MAX_RUNS)
+        {
+            const std::vector<std::size_t> levels = run_levels();
+            const std::size_t upper = (levels.size() > 1) ? levels[1] : levels[0] + 1;
+            merge(runs_of_levels(levels[0], upper), upper);
+        }
+    }
+
+    /// @brief Merges the runs at the positions `sources` of `_runs` into one of `level`, from their heads on.
+    /// It drops the values tombstoned in memory, and the tombstones along with their values
+    /// when both are merged, which leaves the front run the same, see `settle()`.
+    /// The sources are read through streams of their own, and replaced only once the merged run is complete,
+    /// so that a failure leaves them as they were.
+    void merge(const std::vector<std::size_t>& sources, std::size_t level)
+    {
+        const std::filesystem::path path = next_run_path();
+        std::unique_ptr<Run> merged;
+        std::vector<std::uint64_t> resolved;
+        try
+        {
+            std::ofstream out = open_out(path);
+
+            std::vector<std::unique_ptr<Reader>> readers;
+            readers.reserve(sources.size());
+            for (const std::size_t source : sources)
+            {
+                const Reader& reader = _runs[source]->reader;
+                readers.push_back(open_reader(reader.path, reader.position - reader.block.size() + reader.next,
+                                              _runs[source]->count));
+            }
+            const std::size_t count = write_merged(readers, head_less(), out, path, nullptr,
+                                                   [&](const Reader& reader) {
+                                                       if (!tombstoned_in_memory(reader.head()))
+                                                           return false;
+                                                       resolved.push_back(reader.head().stamp - 1);
+                                                       return true;
+                                                   });
+
+            // then the same records by id hash
+            for (const std::size_t source : sources)
+            {
+                const Run& run = *_runs[source];
+                readers.push_back(open_reader(run.reader.path, run.count, run.count * 2));
+                readers.back()->run_head = run.head();
+            }
+            Index index;
+            [[maybe_unused]] const std::size_t index_count =
+                write_merged(readers, id_greater(), out, path, &index, [this](const Reader& reader) {
+                    return tombstoned_in_memory(reader.head()) || precedes(reader.head(), *reader.run_head);
+                });
+            assert(index_count == count);
+            close_out(out, path);
+
+            if (count > 0)
+                merged = open_run(path, count, level, std::move(index));
+            else
+                remove_path(path);
+        }
+        catch (...)
+        {
+            remove_path(path);
+            throw;
+        }
+
+        // from the last one, so that the positions of the others stay put
+        std::vector<std::size_t> sorted_sources = sources;
+        std::ranges::sort(sorted_sources, std::greater{});
+        for (const std::size_t source : sorted_sources)
+        {
+            remove_file(*_runs[source]);
+            _runs.erase(_runs.begin() + static_cast<std::ptrdiff_t>(source));
+        }
+        // can't reallocate, as the sources made room
+        if (merged)
+            _runs.push_back(std::move(merged));
+        std::ranges::make_heap(_runs, head_less());
+
+        for (const std::uint64_t stamp : resolved)
+            erase_tombstone(find_tombstone(stamp));
+    }
+
+    /// @brief Writes the records of `readers` in the order of `less`, but the ones `skip(reader)` tells
+    /// and the tombstones followed by their value, which it drops as well.
+    /// @param index gets the fences of the records, if not null
+    /// @return number of records written
+    template <typename Less, typename Skip>
+    static auto write_merged(std::vector<std::unique_ptr<Reader>>& readers, Less less, std::ofstream& out,
+                             const std::filesystem::path& path, Index* index, Skip skip)
+        -> std::size_t
+    {
+        std::vector<Record> records;
+        records.reserve(RUN_BLOCK);
+        std::size_t count = 0;
+        const auto put = [&](const Record& record) {
+            if (index)
+            {
+                index->last_hash = hash_of(record);
+                if (count % INDEX_BLOCK == 0)
+                    index->fences.push_back(index->last_hash);
+            }
+            records.push_back(record);
+            count += 1;
+            if (records.size() == RUN_BLOCK)
+            {
+                write_records(out, path, records);
+                records.clear();
+            }
+        };
+
+        // held until the next record shows whether its value is merged too
+        std::optional<Record> tombstone;
+        std::ranges::make_heap(readers, less);
+        while (!readers.empty())
+        {
+            const bool skipped = skip(*readers.front());
+            const Record record = readers.front()->head();
+            advance_reader(readers, less);
+            if (skipped)
+                continue;
+
+            if (tombstone && record.stamp == tombstone->stamp + 1)
+            {
+                tombstone.reset();
+                continue;
+            }
+            if (tombstone)
+                put(*std::exchange(tombstone, std::nullopt));
+            if (is_tombstone(record))
+                tombstone = record;
+            else
+                put(record);
+        }
+        if (tombstone)
+            put(*tombstone);
+
+        if (!records.empty())
+            write_records(out, path, records);
+        return count;
+    }
+
+    void add_run(std::unique_ptr<Run> run)
+    {
+        _runs.push_back(std::move(run));
+        std::ranges::push_heap(_runs, head_less());
+    }
+
+    /// @brief Pops the head of the front run if `consume`, then skips the dead records at the front,
+    /// so that its head is live: a tombstone along with its value, which is then the head of another run
+    /// as nothing sorts between them, or a value tombstoned in memory, along with the tombstone.
+    /// The blocks are read aside, and the runs only moved once all the reads succeeded,
+    /// so that a failure leaves them as they were.
+    void settle(bool consume)
+    {
+        std::vector<Cursor> cursors(_runs.size());
+        for (std::size_t pos = 0; pos < _runs.size(); ++pos)
+        {
+            cursors[pos].next = _runs[pos]->reader.next;
+            cursors[pos].position = _runs[pos]->reader.position;
+        }
+        const auto block_of = [&](std::size_t pos) -> const std::vector<Record>& {
+            return cursors[pos].aside ? cursors[pos].block : _runs[pos]->reader.block;
+        };
+        const auto head_of = [&](std::size_t pos) -> const Record* {
+            return (cursors[pos].next < block_of(pos).size()) ? &block_of(pos)[cursors[pos].next] : nullptr;
+        };
+        const auto skip = [&](std::size_t pos) {
+            Cursor& cursor = cursors[pos];
+            Reader& reader = _runs[pos]->reader;
+            if (++cursor.next < block_of(pos).size() || cursor.position == reader.end)
+                return;
+            cursor.block = read_records(reader, cursor.position, std::min(RUN_BLOCK, reader.end - cursor.position));
+            cursor.aside = true;
+            cursor.next = 0;
+            cursor.position += cursor.block.size();
+        };
+
+        std::vector<std::uint64_t> resolved;
+        if (consume)
+            skip(0);
+        while (true)
+        {
+            std::size_t front = NPOS;
+            const Record* front_head = nullptr;
+            for (std::size_t pos = 0; pos < _runs.size(); ++pos)
+            {
+                const Record* run_head = head_of(pos);
+                if (run_head && (!front_head || precedes(*run_head, *front_head)))
+                {
+                    front = pos;
+                    front_head = run_head;
+                }
+            }
+            if (!front_head)
+                break;
+
+            const Record head = *front_head;
+            if (is_tombstone(head))
+            {
+                std::size_t value = 0;
+                while (value < _runs.size() && (!head_of(value) || head_of(value)->stamp != head.stamp + 1))
+                    value += 1;
+                assert(value < _runs.size());
+                skip(front);
+                skip(value);
+            }
+            else if (tombstoned_in_memory(head))
+            {
+                resolved.push_back(head.stamp - 1);
+                skip(front);
+            }
+            else
+                break;
+        }
+
+        // from the last one, so that the positions of the others stay put
+        for (std::size_t pos = _runs.size(); pos-- > 0;)
+        {
+            Reader& reader = _runs[pos]->reader;
+            if (cursors[pos].aside)
+                reader.block = std::move(cursors[pos].block);
+            reader.next = cursors[pos].next;
+            reader.position = cursors[pos].position;
+            if (reader.next == reader.block.size())
+            {
+                remove_file(*_runs[pos]);
+                _runs.erase(_runs.begin() + static_cast<std::ptrdiff_t>(pos));
+            }
+        }
+        std::ranges::make_heap(_runs, head_less());
+
+        for (const std::uint64_t stamp : resolved)
+            erase_tombstone(find_tombstone(stamp));
+    }
+
+    /// @brief Consumes the head of the best of `readers`, and takes the reader out of them once exhausted.
+    template <typename Less>
+    static void advance_reader(std::vector<std::unique_ptr<Reader>>& readers, Less less)
+    {
+        Reader& reader = *readers.front();
+
+        if (++reader.next == reader.block.size())
+        {
+            if (reader.position == reader.end)
+            {
+                std::ranges::pop_heap(readers, less);
+                readers.pop_back();
+                return;
+            }
+            read_block(reader);
+        }
+        sift_down(readers, 0, less);
+    }
+
+    /// @brief Moves the item at `index` down to its place after it went worse, in a single pass,
+    /// where `pop_heap()` and `push_heap()` would take two
+    template <typename Item, typename Less>
+    static void sift_down(std::vector<std::unique_ptr<Item>>& items, std::size_t index, Less less)
+    {
+        while (true)
+        {
+            const std::size_t left = index * 2 + 1;
+            if (left >= items.size())
+                break;
+
+            const std::size_t right = left + 1;
+            const std::size_t bigger = (right < items.size() && less(items[left], items[right])) ? right : left;
+            if (!less(items[index], items[bigger]))
+                break;
+
+            std::swap(items[index], items[bigger]);
+            index = bigger;
+        }
+    }
+
+    /// @brief Tombstones a spilled value in memory, and skips it if it's the head of the front run.
+    void tombstone(const Record& value)
+    {
+        const std::uint64_t stamp = value.stamp - 1;
+        insert_tombstone(Record{.value = value.value, .stamp = stamp});
+        if (_runs.front()->head().stamp != value.stamp)
+            return;
+
+        try
+        {
+            settle(false);
+        }
+        catch (...)
+        {
+            erase_tombstone(find_tombstone(stamp));
+            throw;
+        }
+    }
+
+    /// @return the live spilled value of `id`, looked up in the id section of each run:
+    /// the value of `id` past the head of its run, of which there's a tombstone neither in memory nor in a run
+    auto find_spilled(const UniqueId& id) const -> std::optional<Record>
+    {
+        const std::size_t hash = UniqueIdHash{}(id);
+        std::vector<Record> found;
+        for (const std::unique_ptr<Run>& run : _runs)
+        {
+            if (hash > run->index.last_hash)
+                continue;
+
+            // the records of `hash` may begin at the end of the block before the first fence of it
+            const std::vector<std::size_t>& fences = run->index.fences;
+            const auto first = std::ranges::lower_bound(fences, hash);
+            const auto last = std::ranges::upper_bound(fences, hash);
+            const auto end_block = static_cast<std::size_t>(last - fences.begin());
+            std::size_t block = static_cast<std::size_t>(first - fences.begin());
+            if (block > 0)
+                block -= 1;
+
+            for (; block < end_block; ++block)
+            {
+                const std::size_t position = run->count + block * INDEX_BLOCK;
+                for (const Record& record :
+                     read_records(run->reader, position, std::min(INDEX_BLOCK, run->count * 2 - position)))
+                {
+                    if (hash_of(record) == hash && UniqueIdEqual{}(record.value.unique_id(), id) &&
+                        !precedes(record, run->head()))
+                        found.push_back(record);
+                }
+            }
+        }
+
+        for (const Record& record : found)
+        {
+            if (is_tombstone(record) || tombstoned_in_memory(record))
+                continue;
+            if (std::ranges::none_of(found, [&](const Record& other) { return other.stamp == record.stamp - 1; }))
+                return record;
+        }
+        return std::nullopt;
+    }
+
+    bool top_is_hot() const
+    {
+        assert(!empty());
+        return _runs.empty() || (!_hot.empty() && !Compare{}(_hot.top(), _runs.front()->head().value));
+    }
+
+    /// @return whether `record` is a value whose tombstone is in memory
+    bool tombstoned_in_memory(const Record& record) const
+    {
+        return !is_tombstone(record) && find_tombstone(record.stamp - 1) != NPOS;
+    }
+
+    auto find_tombstone(std::uint64_t stamp) const -> std::size_t
+    {
+        const std::size_t slot = _tombstone_index.find(stamp, tombstone_stamp_of());
+        return (slot == NPOS) ? NPOS : _tombstone_index.position(slot);
+    }
+
+    void insert_tombstone(const Record& record)
+    {
+        const std::size_t pos = _tombstones.size();
+        _tombstones.push_back(Tombstone{.record = record, .slot = NPOS});
+        try
+        {
+            _tombstones[pos].slot = _tombstone_index.insert(record.stamp, pos, on_tombstone_move());
+        }
+        catch (...)
+        {
+            _tombstones.pop_back();
+            throw;
+        }
+    }
+
+    /// @brief Erases the tombstone at `pos`, moving the last one into its place.
+    void erase_tombstone(std::size_t pos)
+    {
+        assert(pos < _tombstones.size());
+
+        _tombstone_index.erase(_tombstones[pos].slot, on_tombstone_move());
+        if (pos != _tombstones.size() - 1)
+        {
+            _tombstones[pos] = _tombstones.back();
+            _tombstone_index.position(_tombstones[pos].slot) = pos;
+        }
+        _tombstones.pop_back();
+    }
+
+    /// @return positions in `_runs` of the runs whose level is in `[first, last]`
+    auto runs_of_levels(std::size_t first, std::size_t last) const -> std::vector<std::size_t>
+    {
+        std::vector<std::size_t> positions;
+        for (std::size_t pos = 0; pos < _runs.size(); ++pos)
+            if (_runs[pos]->level >= first && _runs[pos]->level <= last)
+                positions.push_back(pos);
+        return positions;
+    }
+
+    auto max_level() const -> std::size_t
+    {
+        std::size_t level = 0;
+        for (const std::unique_ptr<Run>& run : _runs)
+            level = std::max(level, run->level);
+        return level;
+    }
+
+    /// @return the levels of the runs, lowest first, each once
+    auto run_levels() const -> std::vector<std::size_t>
+    {
+        std::vector<std::size_t> levels;
+        for (const std::unique_ptr<Run>& run : _runs)
+            levels.push_back(run->level);
+        std::ranges::sort(levels);
+        levels.erase(std::ranges::unique(levels).begin(), levels.end());
+        return levels;
+    }
+
+private:
+    /// @brief Opens a complete run file of `count` records, and reads its first block.
+    static auto open_run(const std::filesystem::path& path, std::size_t count, std::size_t level,
+                         Index index) -> std::unique_ptr<Run>
+    {
+        auto run = std::make_unique<Run>(Run{.reader = Reader{.path = path,
+                                                              .file = std::ifstream(path, std::ios::binary),
+                                                              .block = {},
+                                                              .next = 0,
+                                                              .position = 0,
+                                                              .end = count,
+                                                              .run_head = std::nullopt},
+                                             .count = count,
+                                             .index = std::move(index),
+                                             .level = level});
+        if (!run->reader.file)
+            throw std::runtime_error("failed to open the spill run " + path.string());
+        read_block(run->reader);
+        return run;
+    }
+
+    /// @brief Opens another stream on the records `[position, end)` of a run file, and reads its first block.
+    static auto open_reader(const std::filesystem::path& path, std::size_t position, std::size_t end)
+        -> std::unique_ptr<Reader>
+    {
+        auto reader = std::make_unique<Reader>(Reader{.path = path,
+                                                      .file = std::ifstream(path, std::ios::binary),
+                                                      .block = {},
+                                                      .next = 0,
+                                                      .position = position,
+                                                      .end = end,
+                                                      .run_head = std::nullopt});
+        if (!reader->file)
+            throw std::runtime_error("failed to open the spill run " + path.string());
+        read_block(*reader);
+        return reader;
+    }
+
+    static void read_block(Reader& reader)
+    {
+        reader.block = read_records(reader, reader.position, std::min(RUN_BLOCK, reader.end - reader.position));
+        reader.next = 0;
+        reader.position += reader.block.size();
+    }
+
+    /// @brief Reads `count` records of the file of `reader` from `position`, leaving its block as it is
+    static auto read_records(Reader& reader, std::size_t position, std::size_t count) -> std::vector<Record>
+    {
+        std::vector<Record> records(count);
+        reader.file.clear();
+        reader.file.seekg(static_cast<std::streamoff>(position * sizeof(Record)));
+        reader.file.read(reinterpret_cast<char*>(records.data()),
+                         static_cast<std::streamsize>(count * sizeof(Record)));
+        if (!reader.file)
+            throw std::runtime_error("failed to read the spill run " + reader.path.string());
+        return records;
+    }
+
+    static auto open_out(const std::filesystem::path& path) -> std::ofstream
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+            throw std::runtime_error("failed to create the spill run " + path.string());
+        return out;
+    }
+
+    static void write_records(std::ofstream& out, const std::filesystem::path& path,
+                              const std::vector<Record>& records)
+    {
+        out.write(reinterpret_cast<const char*>(records.data()),
+                  static_cast<std::streamsize>(records.size() * sizeof(Record)));
+        if (!out)
+            throw std::runtime_error("failed to write the spill run " + path.string());
+    }
+
+    /// @brief Flushes the end of a run, which may fail as well
+    static void close_out(std::ofstream& out, const std::filesystem::path& path)
+    {
+        out.close();
+        if (!out)
+            throw std::runtime_error("failed to write the spill run " + path.string());
+    }
+
+    /// @brief Closes and deletes the file of a run, ignoring the errors, as the run isn't needed anymore
+    static void remove_file(Run& run)
+    {
+        run.reader.file.close();
+        remove_path(run.reader.path);
+    }
+
+    static void remove_path(const std::filesystem::path& path)
+    {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+
+    auto next_run_path() -> std::filesystem::path
+    {
+        return _directory / (_file_prefix + "-" + std::to_string(_run_number++) + ".run");
+    }
+
+private:
+    /// @brief Order of the records of a run: best first, then the older first
+    static bool precedes(const Record& left, const Record& right)
+    {
+        if (Compare{}(right.value, left.value))
+            return true;
+        return !Compare{}(left.value, right.value) && left.stamp < right.stamp;
+    }
+
+    /// @brief Order of the id section of a run
+    static bool id_less(const Record& left, const Record& right)
+    {
+        const std::size_t left_hash = hash_of(left);
+        const std::size_t right_hash = hash_of(right);
+        return left_hash < right_hash || (left_hash == right_hash && left.stamp < right.stamp);
+    }
+
+    static auto hash_of(const Record& record) -> std::size_t
+    {
+        return UniqueIdHash{}(record.value.unique_id());
+    }
+
+    static bool is_tombstone(const Record& record)
+    {
+        return record.stamp % 2 == 0;
+    }
+
+    /// @brief Orders runs or readers by their heads, the first record on top
+    static auto head_less()
+    {
+        return [](const auto& left, const auto& right) { return precedes(right->head(), left->head()); };
+    }
+
+    /// @brief Orders the readers of id sections by their heads, the lowest hash on top
+    static auto id_greater()
+    {
+        return [](const auto& left, const auto& right) { return id_less(right->head(), left->head()); };
+    }
+
+    /// @brief Reads the stamp of a tombstone, for `FlatIdIndex`
+    auto tombstone_stamp_of() const
+    {
+        return [this](std::size_t pos) -> const std::uint64_t& { return _tombstones[pos].record.stamp; };
+    }
+
+    /// @brief Follows the slot moves of `FlatIdIndex`
+    auto on_tombstone_move()
+    {
+        return [this](std::size_t pos, std::size_t slot) { _tombstones[pos].slot = slot; };
+    }
+
+public:
+    /// @brief Checks the consistency of the heap, but not the bound of the runs,
+    /// which a failed merge leaves exceeded until the next one succeeds.
+    bool validate() const
+    {
+        if (!_hot.validate() || _hot.size() > size() ||
+            _hot.size() + _tombstones.size() > std::max<std::size_t>(_hot_capacity, 2))
+            return false;
+
+        if (_tombstone_index.size() != _tombstones.size())
+            return false;
+        for (std::size_t pos = 0; pos < _tombstones.size(); ++pos)
+            if (_tombstone_index.position(_tombstones[pos].slot) != pos)
+                return false;
+
+        if (!std::ranges::is_heap(_runs, head_less()))
+            return false;
+        // the front is live, so that `top()` is
+        if (!_runs.empty() && (is_tombstone(_runs.front()->head()) || tombstoned_in_memory(_runs.front()->head())))
+            return false;
+        for (const std::unique_ptr<Run>& run : _runs)
+        {
+            if (run->reader.next >= run->reader.block.size())
+                return false;
+            const Index& index = run->index;
+            if (index.fences.size() != (run->count + INDEX_BLOCK - 1) / INDEX_BLOCK ||
+                !std::ranges::is_sorted(index.fences) || index.last_hash < index.fences.back())
+                return false;
+        }
+        return true;
+    }
+
+private:
+    static constexpr std::size_t NPOS = FlatIdIndex<std::uint64_t>::NPOS;
+
+private:
+    HotHeap _hot;
+    std::size_t _hot_capacity;
+    /// values in the hot heap and live in the runs
+    std::size_t _size = 0;
+
+    /// tombstones not spilled yet, found by stamp through `_tombstone_index`
+    std::vector<Tombstone> _tombstones;
+    FlatIdIndex<std::uint64_t> _tombstone_index;
+    std::uint64_t _last_version = 0;
+
+    /// max-heap of the runs by their heads, see `head_less()`; boxed, as the file streams are slow to move
+    std::vector<std::unique_ptr<Run>> _runs;
+    std::filesystem::path _directory;
+    std::string _file_prefix;
+    std::size_t _run_number = 0;
+};
+
+} // namespace bs
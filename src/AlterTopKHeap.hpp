@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "AlterMinMaxHeap.hpp"
+#include "MemoryUsage.hpp"
+
+namespace bs
+{
+
+/// @brief Keeps the best `capacity()` values of a stream, overwriting the `T` value with the same `T::unique_id()`.
+///
+/// Backed by an `AlterMinMaxHeap`, whose min side finds the worst value to evict in O(1),
+/// so that memory stays O(K) however long the stream is.
+///
+/// @tparam T type of value to store
+/// @tparam Compare ordering of `T`
+/// @tparam UniqueIdHash hasher of `T::unique_id()`
+/// @tparam UniqueIdEqual equality check of `T::unique_id()`
+template <typename T, typename Compare = std::less<T>,
+          typename UniqueIdHash = std::hash<std::invoke_result_t<decltype(&T::unique_id), T>>,
+          typename UniqueIdEqual = std::equal_to<std::invoke_result_t<decltype(&T::unique_id), T>>>
+class AlterTopKHeap
+{
+public:
+    using Heap = AlterMinMaxHeap<T, Compare, UniqueIdHash, UniqueIdEqual>;
+    using UniqueId = typename Heap::UniqueId;
+    using ConstIterator = typename Heap::ConstIterator;
+
+public:
+    /// @param capacity number of values kept, `K`
+    /// @throw std::invalid_argument if `capacity` is 0
+    AlterTopKHeap(std::size_t capacity) : _heap(capacity), _capacity(capacity)
+    {
+        if (capacity == 0)
+            throw std::invalid_argument("AlterTopKHeap needs a capacity of at least 1");
+    }
+
+public: // Element access
+    /// @brief The best value.
+    auto top() const -> const T&
+    {
+        return _heap.top_max();
+    }
+
+    /// @brief The worst value, the next one to be evicted.
+    auto worst() const -> const T&
+    {
+        return _heap.top_min();
+    }
+
+public: // Capacity
+    bool empty() const
+    {
+        return _heap.empty();
+    }
+
+    bool full() const
+    {
+        return size() == _capacity;
+    }
+
+    auto size() const -> std::size_t
+    {
+        return _heap.size();
+    }
+
+    auto capacity() const -> std::size_t
+    {
+        return _capacity;
+    }
+
+public: // Memory
+    auto memory_usage() const -> MemoryUsage
+    {
+        return _heap.memory_usage();
+    }
+
+    auto peak_memory_usage() const -> MemoryUsage
+    {
+        return _heap.peak_memory_usage();
+    }
+
+    void reset_peak()
+    {
+        _heap.reset_peak();
+    }
+
+public: // Modifiers
+    /// @brief Overwrites the value with the same id, or keeps the value if there is room or it beats the worst one.
+    /// @return value dropped from the top K: the evicted worst one, or `value` itself if it doesn't make it,
+    /// `std::nullopt` if nothing was dropped
+    auto push(const T& value) -> std::optional<T>
+    {
+        return push_impl(value);
+    }
+
+    auto push(T&& value) -> std::optional<T>
+    {
+        return push_impl(std::move(value));
+    }
+
+    void pop()
+    {
+        _heap.pop_max();
+    }
+
+    /// @return whether `id` was found and erased
+    bool erase(const UniqueId& id)
+    {
+        return _heap.erase(id);
+    }
+
+    /// @brief `AlterMinMaxHeap::modify()`, which can't evict anything as the size doesn't change.
+    template <typename Fn>
+    bool modify(const UniqueId& id, Fn&& fn)
+    {
+        return _heap.modify(id, std::forward<Fn>(fn));
+    }
+
+public: // Iterators
+    auto begin() const noexcept -> ConstIterator
+    {
+        return _heap.begin();
+    }
+
+    auto end() const noexcept -> ConstIterator
+    {
+        return _heap.end();
+    }
+
+    auto cbegin() const noexcept -> ConstIterator
+    {
+        return _heap.cbegin();
+    }
+
+    auto cend() const noexcept -> ConstIterator
+    {
+        return _heap.cend();
+    }
+
+public: // Lookup
+    auto find(const UniqueId& id) const -> ConstIterator
+    {
+        return _heap.find(id);
+    }
+
+private:
+    template <typename TVal>
+    auto push_impl(TVal&& val) -> std::optional<T>
+    {
+        if (!full() || _heap.find(val.unique_id()) != _heap.cend())
+        {
+            _heap.push(std::forward<TVal>(val));
+            return std::nullopt;
+        }
+
+        if (!Compare{}(_heap.top_min(), val))
+            return T(std::forward<TVal>(val));
+
+        std::optional<T> evicted(_heap.top_min());
+        _heap.pop_min();
+        _heap.push(std::forward<TVal>(val));
+        return evicted;
+    }
+
+public:
+    bool validate() const
+    {
+        return size() <= _capacity && _heap.validate();
+    }
+
+private:
+    Heap _heap;
+    std::size_t _capacity;
+};
+
+} // namespace bs
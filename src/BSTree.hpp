@@ -1,27 +1,48 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <functional>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 
+#include "KeyPolicy.hpp"
+#include "MemoryUsage.hpp"
+#include "NodePayload.hpp"
 #include "TraversalInfo.hpp"
 
 namespace bs
 {
 
-template <typename Key, typename Value, typename Compare = std::less<Key>>
+/// @brief Unbalanced binary search tree.
+///
+/// With `MultiKeys`, equal keys are stored in separate nodes, in insertion order.
+/// With `Value = void` (`BSSet`), nodes store the key only, and traversal callbacks are `op(key, info)`.
+template <typename Key, typename Value, typename Compare = std::less<Key>, typename KeyPolicy = UniqueKeys>
 class BSTree
 {
 private:
-    struct Node
+    struct Node;
+
+    struct NodeLinks
     {
         Node* parent;
         Node* left;
         Node* right;
+    };
 
-        Key key;
-        Value value;
+    using Payload = NodePayload<Key, Value>;
+
+    struct Node : NodeLinks, Payload
+    {
+        template <typename TKey, typename... TValArgs>
+        Node(Node* parent_, Node* nil, TKey&& key_, TValArgs&&... val_args)
+            : NodeLinks{.parent = parent_, .left = nil, .right = nil},
+              Payload(std::forward<TKey>(key_), std::forward<TValArgs>(val_args)...)
+        {
+        }
     };
 
     // To avoid constructing `Key`, `Value` for nil node
@@ -30,6 +51,10 @@ private:
         Node* parent;
     };
 
+public:
+    /// `Value`, or `const Key` for sets
+    using Mapped = std::remove_reference_t<decltype(std::declval<Payload&>().mapped())>;
+
 public:
     BSTree() : _nil_node{.parent = &get_nil()}, _root(&get_nil())
     {
@@ -41,20 +66,15 @@ public:
     }
 
 public:
-    // Doesn't insert if same key present
+    // Doesn't insert if same key present, unless `MultiKeys`
     template <typename TKey, typename... TValArgs>
     bool insert(TKey&& key, TValArgs&&... val_args)
     {
         if (is_nil(*_root))
         {
-            _root = new Node{
-                .parent = &get_nil(),
-                .left = &get_nil(),
-                .right = &get_nil(),
-                .key = std::forward<TKey>(key),
-                .value = Value(std::forward<TValArgs>(val_args)...),
-            };
+            _root = new Node(&get_nil(), &get_nil(), std::forward<TKey>(key), std::forward<TValArgs>(val_args)...);
             _size += 1;
+            _peak_size = std::max(_peak_size, _size);
             return true;
         }
 
@@ -65,18 +85,14 @@ public:
 
     // Overwrite if same key present
     template <typename TKey, typename... TValArgs>
+        requires(!KeyPolicy::ALLOW_DUPLICATES && !std::is_void_v<Value>)
     bool insert_or_assign(TKey&& key, TValArgs&&... val_args)
     {
         if (is_nil(*_root))
         {
-            _root = new Node{
-                .parent = &get_nil(),
-                .left = &get_nil(),
-                .right = &get_nil(),
-                .key = std::forward<TKey>(key),
-                .value = Value(std::forward<TValArgs>(val_args)...),
-            };
+            _root = new Node(&get_nil(), &get_nil(), std::forward<TKey>(key), std::forward<TValArgs>(val_args)...);
             _size += 1;
+            _peak_size = std::max(_peak_size, _size);
             return true;
         }
 
@@ -85,26 +101,54 @@ public:
         return inserted;
     }
 
+    /// @brief Erases every node of `key`.
     bool erase(const Key& key)
     {
-        const bool erased = erase_recurse(*_root, key);
+        bool erased = false;
+        while (erase_recurse(*_root, key))
+        {
+            erased = true;
+            if constexpr (!KeyPolicy::ALLOW_DUPLICATES)
+                break;
+        }
         return erased;
     }
 
-    auto find(const Key& key) -> Value*
+    /// @brief Finds the first inserted one of equal keys.
+    auto find(const Key& key) -> Mapped*
     {
         Node& node = find_recurse(*_root, key);
         if (is_nil(node))
             return nullptr;
-        return &node.value;
+        return &node.mapped();
     }
 
-    auto find(const Key& key) const -> const Value*
+    auto find(const Key& key) const -> const Mapped*
     {
         const Node& node = find_recurse(*_root, key);
         if (is_nil(node))
             return nullptr;
-        return &node.value;
+        return &node.mapped();
+    }
+
+    auto count(const Key& key) const -> std::size_t
+    {
+        std::size_t result = 0;
+        equal_range(key, [&result](const auto&...) { ++result; });
+        return result;
+    }
+
+    /// @brief Calls `op(key, value, info)`, or `op(key, info)` for sets, on every node of `key`, in insertion order.
+    template <typename Operation>
+    void equal_range(const Key& key, Operation op)
+    {
+        equal_range_recurse(*_root, key, op, 0);
+    }
+
+    template <typename Operation>
+    void equal_range(const Key& key, Operation op) const
+    {
+        equal_range_recurse(*_root, key, op, 0);
     }
 
 public:
@@ -155,6 +199,23 @@ public:
         return _size;
     }
 
+public:
+    auto memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(_size);
+    }
+
+    /// @brief Memory usage at the largest size since construction or the last `reset_peak()`.
+    auto peak_memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(_peak_size);
+    }
+
+    void reset_peak()
+    {
+        _peak_size = _size;
+    }
+
 public:
     void clear()
     {
@@ -173,38 +234,29 @@ private:
                 return insert_recurse(*cur.left, assign, std::forward<TKey>(key), std::forward<TValArgs>(val_args)...);
             else
             {
-                cur.left = new Node{
-                    .parent = &cur,
-                    .left = &get_nil(),
-                    .right = &get_nil(),
-                    .key = std::forward<TKey>(key),
-                    .value = Value(std::forward<TValArgs>(val_args)...),
-                };
+                cur.left = new Node(&cur, &get_nil(), std::forward<TKey>(key), std::forward<TValArgs>(val_args)...);
                 _size += 1;
+                _peak_size = std::max(_peak_size, _size);
                 return true;
             }
         }
-        else if (greater(key, cur.key))
+        else if (KeyPolicy::ALLOW_DUPLICATES || greater(key, cur.key))
         {
             if (!is_nil(*cur.right))
                 return insert_recurse(*cur.right, assign, std::forward<TKey>(key), std::forward<TValArgs>(val_args)...);
             else
             {
-                cur.right = new Node{
-                    .parent = &cur,
-                    .left = &get_nil(),
-                    .right = &get_nil(),
-                    .key = std::forward<TKey>(key),
-                    .value = Value(std::forward<TValArgs>(val_args)...),
-                };
+                cur.right = new Node(&cur, &get_nil(), std::forward<TKey>(key), std::forward<TValArgs>(val_args)...);
                 _size += 1;
+                _peak_size = std::max(_peak_size, _size);
                 return true;
             }
         }
         // equal
 
-        if (assign)
-            cur.value = Value(std::forward<TValArgs>(val_args)...);
+        if constexpr (!std::is_void_v<Value>)
+            if (assign)
+                cur.value = Value(std::forward<TValArgs>(val_args)...);
         return false;
     }
 
@@ -218,6 +270,11 @@ private:
         if (greater(key, cur.key))
             return erase_recurse(*cur.right, key);
         // equal
+
+        // erase the first inserted one, to keep the order of the others
+        if constexpr (KeyPolicy::ALLOW_DUPLICATES)
+            if (erase_recurse(*cur.left, key))
+                return true;
         return erase_node(cur);
     }
 
@@ -236,7 +293,8 @@ private:
 
             // move the key & value to `cur`
             cur.key = std::move(right_most->key);
-            cur.value = std::move(right_most->value);
+            if constexpr (!std::is_void_v<Value>)
+                cur.value = std::move(right_most->value);
 
             // remove `right_most`
             if (!erase_node(*right_most))
@@ -276,6 +334,13 @@ private:
         if (greater(key, cur.key))
             return find_recurse(*cur.right, key);
         // equal
+
+        if constexpr (KeyPolicy::ALLOW_DUPLICATES)
+        {
+            auto& earlier = find_recurse(*cur.left, key);
+            if (!is_nil(earlier))
+                return earlier;
+        }
         return cur;
     }
 
@@ -285,25 +350,43 @@ private:
             return get_nil();
 
         if (less(key, cur.key))
-            return find(*cur.left, key);
+            return find_recurse(*cur.left, key);
         if (greater(key, cur.key))
-            return find(*cur.right, key);
+            return find_recurse(*cur.right, key);
         // equal
+
+        if constexpr (KeyPolicy::ALLOW_DUPLICATES)
+        {
+            auto& earlier = find_recurse(*cur.left, key);
+            if (!is_nil(earlier))
+                return earlier;
+        }
         return cur;
     }
 
 private:
+    template <typename Operation>
+    void equal_range_recurse(Node& cur, const Key& key, Operation& op, std::size_t complete_index) const
+    {
+        if (is_nil(cur))
+            return;
+
+        // moving the predecessor up on erase may leave equal keys on both sides
+        if (!less(cur.key, key))
+            equal_range_recurse(*cur.left, key, op, complete_index * 2 + 1);
+        if (equal(key, cur.key))
+            cur.visit(op, TraversalInfo{.complete_index = complete_index, .red = true});
+        if (!greater(cur.key, key))
+            equal_range_recurse(*cur.right, key, op, complete_index * 2 + 2);
+    }
+
     template <typename Operation>
     void preorder_recurse(Node& cur, Operation op, std::size_t complete_index)
     {
         if (is_nil(cur))
             return;
 
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = true,
-           });
+        cur.visit(op, TraversalInfo{.complete_index = complete_index, .red = true});
         preorder_recurse(*cur.left, op, complete_index * 2 + 1);
         preorder_recurse(*cur.right, op, complete_index * 2 + 2);
     }
@@ -314,11 +397,7 @@ private:
         if (is_nil(cur))
             return;
 
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = true,
-           });
+        cur.visit(op, TraversalInfo{.complete_index = complete_index, .red = true});
         preorder_recurse(*cur.left, op, complete_index * 2 + 1);
         preorder_recurse(*cur.right, op, complete_index * 2 + 2);
     }
@@ -330,11 +409,7 @@ private:
             return;
 
         inorder_recurse(*cur.left, op, complete_index * 2 + 1);
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = true,
-           });
+        cur.visit(op, TraversalInfo{.complete_index = complete_index, .red = true});
         inorder_recurse(*cur.right, op, complete_index * 2 + 2);
     }
 
@@ -345,11 +420,7 @@ private:
             return;
 
         inorder_recurse(*cur.left, op, complete_index * 2 + 1);
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = true,
-           });
+        cur.visit(op, TraversalInfo{.complete_index = complete_index, .red = true});
         inorder_recurse(*cur.right, op, complete_index * 2 + 2);
     }
 
@@ -361,11 +432,7 @@ private:
 
         postorder_recurse(*cur.left, op, complete_index * 2 + 1);
         postorder_recurse(*cur.right, op, complete_index * 2 + 2);
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = true,
-           });
+        cur.visit(op, TraversalInfo{.complete_index = complete_index, .red = true});
     }
 
     template <typename Operation>
@@ -376,11 +443,7 @@ private:
 
         postorder_recurse(*cur.left, op, complete_index * 2 + 1);
         postorder_recurse(*cur.right, op, complete_index * 2 + 2);
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = true,
-           });
+        cur.visit(op, TraversalInfo{.complete_index = complete_index, .red = true});
     }
 
     void clear_recurse(Node& cur)
@@ -409,6 +472,19 @@ private:
         return reinterpret_cast<Node&>(_nil_node);
     }
 
+private:
+    auto memory_usage_of(std::size_t node_count) const -> MemoryUsage
+    {
+        constexpr std::size_t MEMBER_BYTES = 3 * sizeof(Node*) + Payload::MEMBER_BYTES;
+
+        return MemoryUsage{
+            .node_count = node_count,
+            .node_bytes = node_count * sizeof(Node),
+            .padding_bytes = node_count * (sizeof(Node) - MEMBER_BYTES),
+            .overhead_bytes = node_count * allocation_overhead(sizeof(Node)) + sizeof(*this),
+        };
+    }
+
 private:
     static bool less(const Key& k1, const Key& k2)
     {
@@ -427,9 +503,13 @@ private:
 
 private:
     std::size_t _size = 0;
+    std::size_t _peak_size = 0;
 
     NilNode _nil_node;
     Node* _root;
 };
 
+template <typename Key, typename Compare = std::less<Key>, typename KeyPolicy = UniqueKeys>
+using BSSet = BSTree<Key, void, Compare, KeyPolicy>;
+
 } // namespace bs
@@ -50,7 +50,7 @@ void BSTreeScene::redraw_tree()
 {
     _node_circles.clear();
 
-    _tree.postorder([this](int key, [[maybe_unused]] int val, const bs::TraversalInfo& info) {
+    _tree.postorder([this](int key, const bs::TraversalInfo& info) {
         _node_circles.emplace_back(key, info.complete_index, info.red);
     });
 
@@ -64,7 +64,7 @@ void BSTreeScene::redraw_tree()
 void BSTreeScene::on_number_input(int number)
 {
     // erase if `number` already exists
-    if (!_tree.insert(number, number))
+    if (!_tree.insert(number))
         _tree.erase(number);
 
     redraw_tree();
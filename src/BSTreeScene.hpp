@@ -27,7 +27,7 @@ private:
     void on_number_input(int number);
 
 private:
-    RBTree<int, int> _tree;
+    RBSet<int> _tree;
 
     int _black_depth;
     bool _valid;
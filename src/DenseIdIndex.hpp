@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "FlatIdIndex.hpp"
+#include "Prefetch.hpp"
+
+namespace bs
+{
+
+/// @brief Direct-indexed index from a small dense integral id to a position in a container,
+/// with the interface of `FlatIdIndex`.
+///
+/// The slot of an id is the id itself, so that a lookup is a single memory access, without hashing nor probing.
+/// Slots never move, so `on_move` is never called.
+/// The table grows on demand up to the largest id inserted, so its memory is proportional to that id.
+///
+/// @tparam UniqueId integral id type
+/// @tparam IdCapacity ids should be in `[0, IdCapacity)`
+template <std::integral UniqueId, std::size_t IdCapacity>
+class DenseIdIndex
+{
+public:
+    static constexpr std::size_t NPOS = SIZE_MAX;
+
+    static_assert(IdCapacity != 0 && IdCapacity < NPOS);
+
+private:
+    static constexpr std::size_t MIN_CAPACITY = 16;
+
+public:
+    /// @return slot of `id`, or `NPOS` if not found
+    template <typename IdOf>
+    auto find(const UniqueId& id, [[maybe_unused]] IdOf id_of) const -> std::size_t
+    {
+        const std::size_t slot = slot_of(id);
+        if (slot >= _positions.size() || _positions[slot] == NPOS)
+            return NPOS;
+        return slot;
+    }
+
+    /// @brief Starts loading the slot of `id` into the cache, ahead of `find()` or `insert()`.
+    void prefetch(const UniqueId& id) const
+    {
+        const std::size_t slot = slot_of(id);
+        if (slot < _positions.size())
+            bs::prefetch(&_positions[slot]);
+    }
+
+    /// @brief Inserts `id`, which should not be present.
+    /// @return slot of `id`
+    /// @throw std::out_of_range if `id` is not in `[0, IdCapacity)`
+    template <typename OnMove>
+    auto insert(const UniqueId& id, std::size_t position, [[maybe_unused]] OnMove on_move) -> std::size_t
+    {
+        const std::size_t slot = slot_of(id);
+        if (slot >= IdCapacity)
+            throw std::out_of_range("id out of the dense range of the index");
+
+        if (slot >= _positions.size())
+            _positions.resize(std::min(std::max(std::bit_ceil(slot + 1), MIN_CAPACITY), IdCapacity), NPOS);
+
+        assert(_positions[slot] == NPOS);
+        _positions[slot] = position;
+        _size += 1;
+        return slot;
+    }
+
+    template <typename OnMove>
+    void erase(std::size_t slot, [[maybe_unused]] OnMove on_move)
+    {
+        assert(slot < _positions.size() && _positions[slot] != NPOS);
+
+        _positions[slot] = NPOS;
+        _size -= 1;
+    }
+
+    /// @brief Position stored in `slot`, to be updated as the element moves in the container.
+    auto position(std::size_t slot) -> std::size_t&
+    {
+        return _positions[slot];
+    }
+
+    auto position(std::size_t slot) const -> std::size_t
+    {
+        return _positions[slot];
+    }
+
+    /// @brief No-op: the table is sized by the largest id, not by the number of ids.
+    template <typename OnMove>
+    void reserve([[maybe_unused]] std::size_t size, [[maybe_unused]] OnMove on_move)
+    {
+    }
+
+    void clear()
+    {
+        std::ranges::fill(_positions, NPOS);
+        _size = 0;
+    }
+
+    auto size() const -> std::size_t
+    {
+        return _size;
+    }
+
+    /// @brief Number of slots.
+    auto capacity() const -> std::size_t
+    {
+        return _positions.size();
+    }
+
+    auto memory_bytes() const -> std::size_t
+    {
+        return _positions.capacity() * sizeof(std::size_t);
+    }
+
+private:
+    /// @brief Negative ids wrap around to huge slots, out of range like the too large ones
+    static auto slot_of(const UniqueId& id) -> std::size_t
+    {
+        if constexpr (std::same_as<UniqueId, std::size_t>)
+            return id;
+        else
+            return static_cast<std::size_t>(id);
+    }
+
+private:
+    std::vector<std::size_t> _positions;
+    std::size_t _size = 0;
+};
+
+/// @brief `DenseIdIndex` if `UniqueId` is integral and `IdCapacity` is given (non-zero), `FlatIdIndex` otherwise.
+template <typename UniqueId, typename UniqueIdHash, typename UniqueIdEqual, std::size_t IdCapacity>
+struct SelectIdIndex
+{
+    using type = FlatIdIndex<UniqueId, UniqueIdHash, UniqueIdEqual>;
+};
+
+template <std::integral UniqueId, typename UniqueIdHash, typename UniqueIdEqual, std::size_t IdCapacity>
+    requires(IdCapacity != 0)
+struct SelectIdIndex<UniqueId, UniqueIdHash, UniqueIdEqual, IdCapacity>
+{
+    using type = DenseIdIndex<UniqueId, IdCapacity>;
+};
+
+template <typename UniqueId, typename UniqueIdHash, typename UniqueIdEqual, std::size_t IdCapacity>
+using IdIndexFor = typename SelectIdIndex<UniqueId, UniqueIdHash, UniqueIdEqual, IdCapacity>::type;
+
+} // namespace bs
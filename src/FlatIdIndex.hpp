@@ -0,0 +1,213 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Prefetch.hpp"
+
+namespace bs
+{
+
+/// @brief Open-addressing (linear probing) hash index from a unique id to a position in a container.
+///
+/// It doesn't store the ids: probes compare the cached hashes first, then call `id_of(position)`,
+/// which reads the id from the container. In turn, the container stores the slot of each element,
+/// so that it can update the position in O(1) as elements move, see `position()`.
+///
+/// Slots move on erase (backward-shift deletion, no tombstones) and rehash,
+/// and `on_move(position, new_slot)` is called for each moved one.
+///
+/// @tparam UniqueId id type
+/// @tparam UniqueIdHash hasher of `UniqueId`
+/// @tparam UniqueIdEqual equality check of `UniqueId`
+template <typename UniqueId, typename UniqueIdHash = std::hash<UniqueId>,
+          typename UniqueIdEqual = std::equal_to<UniqueId>>
+class FlatIdIndex
+{
+public:
+    static constexpr std::size_t NPOS = SIZE_MAX;
+
+private:
+    struct Slot
+    {
+        /// position in the container, `NPOS` if empty
+        std::size_t position = NPOS;
+        std::size_t hash = 0;
+    };
+
+    static constexpr std::size_t MIN_CAPACITY = 16;
+    // grows at 3/4 load
+    static constexpr std::size_t MAX_LOAD_NUM = 3;
+    static constexpr std::size_t MAX_LOAD_DEN = 4;
+
+public:
+    /// @return slot of `id`, or `NPOS` if not found
+    template <typename IdOf>
+    auto find(const UniqueId& id, IdOf id_of) const -> std::size_t
+    {
+        if (_slots.empty())
+            return NPOS;
+
+        const std::size_t hash = hash_of(id);
+        for (std::size_t slot = home_slot(hash);; slot = next_slot(slot))
+        {
+            const Slot& cur = _slots[slot];
+            if (cur.position == NPOS)
+                return NPOS;
+            if (cur.hash == hash && UniqueIdEqual{}(id_of(cur.position), id))
+                return slot;
+        }
+    }
+
+    /// @brief Starts loading the home slot of `id` into the cache, ahead of `find()` or `insert()`.
+    void prefetch(const UniqueId& id) const
+    {
+        if (!_slots.empty())
+            bs::prefetch(&_slots[home_slot(hash_of(id))]);
+    }
+
+    /// @brief Inserts `id`, which should not be present.
+    /// @return slot of `id`
+    template <typename OnMove>
+    auto insert(const UniqueId& id, std::size_t position, OnMove on_move) -> std::size_t
+    {
+        if ((_size + 1) * MAX_LOAD_DEN > _slots.size() * MAX_LOAD_NUM)
+            rehash(std::max(MIN_CAPACITY, _slots.size() * 2), on_move);
+
+        const std::size_t hash = hash_of(id);
+        std::size_t slot = home_slot(hash);
+        while (_slots[slot].position != NPOS)
+            slot = next_slot(slot);
+
+        _slots[slot] = Slot{.position = position, .hash = hash};
+        _size += 1;
+        return slot;
+    }
+
+    template <typename OnMove>
+    void erase(std::size_t slot, OnMove on_move)
+    {
+        assert(slot < _slots.size() && _slots[slot].position != NPOS);
+
+        // shift the following entries of the cluster back, if it brings them closer to their home slot
+        std::size_t hole = slot;
+        for (std::size_t cur = next_slot(hole);; cur = next_slot(cur))
+        {
+            Slot& entry = _slots[cur];
+            if (entry.position == NPOS)
+                break;
+
+            const std::size_t home = home_slot(entry.hash);
+            // `home` cyclically in (hole, cur] means the entry can't move to `hole`
+            const bool stays = (hole < cur) ? (hole < home && home <= cur) : (hole < home || home <= cur);
+            if (stays)
+                continue;
+
+            _slots[hole] = entry;
+            on_move(entry.position, hole);
+            hole = cur;
+        }
+
+        _slots[hole] = Slot{};
+        _size -= 1;
+    }
+
+    /// @brief Position stored in `slot`, to be updated as the element moves in the container.
+    auto position(std::size_t slot) -> std::size_t&
+    {
+        return _slots[slot].position;
+    }
+
+    auto position(std::size_t slot) const -> std::size_t
+    {
+        return _slots[slot].position;
+    }
+
+    /// @brief Makes room for `size` ids without rehashing.
+    template <typename OnMove>
+    void reserve(std::size_t size, OnMove on_move)
+    {
+        std::size_t capacity = std::max(MIN_CAPACITY, _slots.size());
+        while (size * MAX_LOAD_DEN > capacity * MAX_LOAD_NUM)
+            capacity *= 2;
+
+        if (capacity != _slots.size())
+            rehash(capacity, on_move);
+    }
+
+    void clear()
+    {
+        std::ranges::fill(_slots, Slot{});
+        _size = 0;
+    }
+
+    auto size() const -> std::size_t
+    {
+        return _size;
+    }
+
+    /// @brief Number of slots.
+    auto capacity() const -> std::size_t
+    {
+        return _slots.size();
+    }
+
+    auto memory_bytes() const -> std::size_t
+    {
+        return _slots.capacity() * sizeof(Slot);
+    }
+
+private:
+    template <typename OnMove>
+    void rehash(std::size_t capacity, OnMove on_move)
+    {
+        assert(std::has_single_bit(capacity));
+
+        std::vector<Slot> old_slots(capacity);
+        old_slots.swap(_slots);
+        _shift = 64 - std::countr_zero(capacity);
+
+        for (const Slot& entry : old_slots)
+        {
+            if (entry.position == NPOS)
+                continue;
+
+            std::size_t slot = home_slot(entry.hash);
+            while (_slots[slot].position != NPOS)
+                slot = next_slot(slot);
+
+            _slots[slot] = entry;
+            on_move(entry.position, slot);
+        }
+    }
+
+    static auto hash_of(const UniqueId& id) -> std::size_t
+    {
+        return UniqueIdHash{}(id);
+    }
+
+    /// @brief Fibonacci hashing, which spreads the identity hashes of integers
+    auto home_slot(std::size_t hash) const -> std::size_t
+    {
+        return (hash * UINT64_C(0x9E3779B97F4A7C15)) >> _shift;
+    }
+
+    auto next_slot(std::size_t slot) const -> std::size_t
+    {
+        return (slot + 1) & (_slots.size() - 1);
+    }
+
+private:
+    std::vector<Slot> _slots;
+    std::size_t _size = 0;
+
+    /// `64 - log2(capacity)`
+    int _shift = 64;
+};
+
+} // namespace bs
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+namespace bs
+{
+
+/// @brief Read-only sorted array of key-value pairs, looked up with a binary search.
+/// Made by `RBTree::to_flat_table()`, usually at compile time.
+template <typename Key, typename Value, std::size_t N, typename Compare = std::less<Key>>
+struct FlatTable
+{
+    using Entry = std::pair<Key, Value>;
+
+    std::array<Entry, N> entries{};
+
+public:
+    constexpr auto find(const Key& key) const -> const Value*
+    {
+        const auto it = std::lower_bound(entries.begin(), entries.end(), key,
+                                         [](const Entry& entry, const Key& k) { return Compare{}(entry.first, k); });
+        if (it == entries.end() || Compare{}(key, it->first))
+            return nullptr;
+        return &it->second;
+    }
+
+    constexpr bool contains(const Key& key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    constexpr auto size() const -> std::size_t
+    {
+        return N;
+    }
+
+    constexpr auto begin() const
+    {
+        return entries.begin();
+    }
+
+    constexpr auto end() const
+    {
+        return entries.end();
+    }
+};
+
+} // namespace bs
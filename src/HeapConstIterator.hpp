@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace bs
+{
+
+/// @brief Random Access Iterator over the values of a heap, whose nodes are stored contiguously.
+/// The order is the storage order of the engine, not the priority order.
+///
+/// @tparam T type of value
+/// @tparam Node node type of the heap, which stores a `T value`
+template <typename T, typename Node>
+class HeapConstIterator
+{
+public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+private:
+    const std::vector<Node>* _nodes;
+    std::size_t _index;
+
+private:
+    auto node() const -> const Node&
+    {
+        return (*_nodes)[_index];
+    }
+
+public:
+    HeapConstIterator(const std::vector<Node>& nodes, std::size_t index) : _nodes(&nodes), _index(index)
+    {
+    }
+
+    auto operator*() const -> const T&
+    {
+        return node().value;
+    }
+
+    auto operator->() const -> const T*
+    {
+        return &node().value;
+    }
+
+    auto operator[](std::ptrdiff_t index) const -> const T&
+    {
+        return (*_nodes)[_index + index].value;
+    }
+
+    auto operator-(const HeapConstIterator& other) const -> std::ptrdiff_t
+    {
+        return _index - other._index;
+    }
+
+    bool operator==(const HeapConstIterator& other) const
+    {
+        return _index == other._index;
+    }
+
+    auto operator<=>(const HeapConstIterator& other) const
+    {
+        return _index <=> other._index;
+    }
+
+    auto operator+(std::ptrdiff_t diff) const -> HeapConstIterator
+    {
+        return HeapConstIterator(*_nodes, _index + diff);
+    }
+
+    auto operator+=(std::ptrdiff_t diff) -> HeapConstIterator&
+    {
+        _index += diff;
+        return *this;
+    }
+
+    auto operator-(std::ptrdiff_t diff) const -> HeapConstIterator
+    {
+        return HeapConstIterator(*_nodes, _index - diff);
+    }
+
+    auto operator-=(std::ptrdiff_t diff) -> HeapConstIterator&
+    {
+        _index -= diff;
+        return *this;
+    }
+
+    auto operator++() -> HeapConstIterator&
+    {
+        ++_index;
+        return *this;
+    }
+
+    auto operator++(int) -> HeapConstIterator
+    {
+        auto it = *this;
+        operator++();
+        return it;
+    }
+
+    auto operator--() -> HeapConstIterator&
+    {
+        --_index;
+        return *this;
+    }
+
+    auto operator--(int) -> HeapConstIterator
+    {
+        auto it = *this;
+        operator--();
+        return it;
+    }
+};
+
+} // namespace bs
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace bs
+{
+
+/// @brief Input Iterator over the values of an array-based d-ary heap in priority order, best first,
+/// without copying nor modifying the heap.
+///
+/// It keeps a frontier of heap indices, itself a heap: the best of the frontier is the next value,
+/// and stepping past it replaces it with its children. The first `k` values cost O(k log k).
+/// Any modification of the heap invalidates it.
+///
+/// @tparam T type of value
+/// @tparam Node node type of the heap, which stores a `T value` and is ordered by `operator<`
+/// @tparam Arity number of children per node of the heap
+template <typename T, typename Node, std::size_t Arity>
+class HeapSortedIterator
+{
+public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+
+private:
+    const std::vector<Node>* _nodes = nullptr;
+    /// max-heap of the heap indices not visited yet, whose parents were
+    std::vector<std::size_t> _frontier;
+
+private:
+    auto frontier_less() const
+    {
+        return [this](std::size_t left, std::size_t right) { return (*_nodes)[left] < (*_nodes)[right]; };
+    }
+
+public:
+    HeapSortedIterator() = default;
+
+    explicit HeapSortedIterator(const std::vector<Node>& nodes) : _nodes(&nodes)
+    {
+        if (!nodes.empty())
+            _frontier.push_back(0);
+    }
+
+    auto operator*() const -> const T&
+    {
+        return (*_nodes)[_frontier.front()].value;
+    }
+
+    auto operator->() const -> const T*
+    {
+        return &(*_nodes)[_frontier.front()].value;
+    }
+
+    auto operator++() -> HeapSortedIterator&
+    {
+        std::ranges::pop_heap(_frontier, frontier_less());
+        const std::size_t index = _frontier.back();
+        _frontier.pop_back();
+
+        const std::size_t first_child = index * Arity + 1;
+        for (std::size_t child = first_child; child < std::min(first_child + Arity, _nodes->size()); ++child)
+        {
+            _frontier.push_back(child);
+            std::ranges::push_heap(_frontier, frontier_less());
+        }
+        return *this;
+    }
+
+    void operator++(int)
+    {
+        operator++();
+    }
+
+    bool operator==(std::default_sentinel_t) const
+    {
+        return _frontier.empty();
+    }
+};
+
+} // namespace bs
@@ -0,0 +1,19 @@
+#pragma once
+
+namespace bs
+{
+
+/// @brief Key policy of the trees: each key is stored at most once, like `std::map`.
+struct UniqueKeys
+{
+    static constexpr bool ALLOW_DUPLICATES = false;
+};
+
+/// @brief Key policy of the trees: equal keys are stored in separate nodes, like `std::multimap`.
+/// Equal keys keep their insertion order.
+struct MultiKeys
+{
+    static constexpr bool ALLOW_DUPLICATES = true;
+};
+
+} // namespace bs
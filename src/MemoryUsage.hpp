@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+
+namespace bs
+{
+
+/// @brief Heap memory held by a container, as reported by `memory_usage()` of each container.
+///
+/// Allocator bookkeeping can't be queried portably, so it's estimated with `allocation_overhead()`.
+struct MemoryUsage
+{
+    std::size_t node_count = 0;
+
+    /// `sizeof` of every node, `padding_bytes` included
+    std::size_t node_bytes = 0;
+    /// alignment padding inside the nodes
+    std::size_t padding_bytes = 0;
+    /// estimated allocator bookkeeping of every allocation, plus the container object itself
+    std::size_t overhead_bytes = 0;
+
+    /// hash table buckets
+    std::size_t bucket_bytes = 0;
+    /// capacity of contiguous arrays
+    std::size_t array_bytes = 0;
+
+    auto total_bytes() const -> std::size_t
+    {
+        return node_bytes + overhead_bytes + bucket_bytes + array_bytes;
+    }
+};
+
+/// @brief Estimated bookkeeping of a single `operator new(size)`,
+/// assuming a glibc-like allocator: one pointer-sized header, rounded up to twice the pointer size.
+/// 0 for an empty block, which a container doesn't allocate.
+constexpr auto allocation_overhead(std::size_t size) -> std::size_t
+{
+    if (size == 0)
+        return 0;
+
+    constexpr std::size_t HEADER = sizeof(void*);
+    constexpr std::size_t GRANULE = 2 * sizeof(void*);
+    constexpr std::size_t MIN_CHUNK = 4 * sizeof(void*);
+
+    std::size_t chunk = (size + HEADER + GRANULE - 1) / GRANULE * GRANULE;
+    if (chunk < MIN_CHUNK)
+        chunk = MIN_CHUNK;
+    return chunk - size;
+}
+
+} // namespace bs
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "AlterHeap.hpp"
+
+namespace bs
+{
+
+/// @brief Thread-safe relaxed priority queue: `c * P` internally locked `AlterHeap`s, for `P` threads.
+///
+/// `push()` goes to the shard owning the `unique_id()`, picked by hashing it, so that the value is overwritten
+/// in place like in `AlterBinaryHeap`, and `erase()`/`modify()` go straight to that shard.
+/// `try_pop()` samples two random shards and pops the better of their tops, so it's not strictly ordered,
+/// but the threads rarely wait on the same lock.
+///
+/// @tparam T type of value to store
+/// @tparam Engine heap engine of the shards, see `AlterHeap`
+/// @tparam Compare ordering of `T`
+/// @tparam UniqueIdHash hasher of `T::unique_id()`
+/// @tparam UniqueIdEqual equality check of `T::unique_id()`
+template <typename T, typename Engine = DaryHeapEngine<>, typename Compare = std::less<T>,
+          typename UniqueIdHash = std::hash<std::invoke_result_t<decltype(&T::unique_id), T>>,
+          typename UniqueIdEqual = std::equal_to<std::invoke_result_t<decltype(&T::unique_id), T>>>
+class MultiQueue
+{
+public:
+    using Heap = AlterHeap<T, Engine, Compare, UniqueIdHash, UniqueIdEqual>;
+    using UniqueId = typename Heap::UniqueId;
+
+    static_assert(!Heap::MONOTONE, "the relaxed pops of the shards don't keep a monotone engine monotone");
+
+private:
+    /// separate cache lines, so that the locks of different shards don't contend
+    static constexpr std::size_t CACHE_LINE = 64;
+
+    /// failed samplings before `try_pop()` falls back to scanning every shard
+    static constexpr int MAX_SAMPLE_ATTEMPTS = 8;
+
+    struct alignas(CACHE_LINE) Shard
+    {
+        mutable std::mutex mutex;
+        Heap heap;
+    };
+
+    /// @brief Output iterator into a `std::optional`, for the single value `pop_k(1, …)` moves out
+    struct OptionalOutput
+    {
+        using difference_type = std::ptrdiff_t;
+
+        std::optional<T>* target;
+
+        auto operator*() const -> const OptionalOutput&
+        {
+            return *this;
+        }
+
+        auto operator=(T&& value) const -> const OptionalOutput&
+        {
+            target->emplace(std::move(value));
+            return *this;
+        }
+
+        auto operator++() -> OptionalOutput&
+        {
+            return *this;
+        }
+
+        auto operator++(int) -> OptionalOutput
+        {
+            return *this;
+        }
+    };
+
+public:
+    /// @param thread_count number of threads expected to share the queue, `P`
+    /// @param queues_per_thread shards per thread, `c`
+    /// @throw std::invalid_argument if either is 0
+    MultiQueue(std::size_t thread_count, std::size_t queues_per_thread = 2)
+        : _shard_count(thread_count * queues_per_thread)
+    {
+        if (thread_count == 0 || queues_per_thread == 0)
+            throw std::invalid_argument("MultiQueue needs at least 1 thread and 1 queue per thread");
+
+        _shards = std::make_unique<Shard[]>(_shard_count);
+    }
+
+    MultiQueue(const MultiQueue&) = delete;
+    MultiQueue& operator=(const MultiQueue&) = delete;
+
+public: // Capacity
+    /// @brief Snapshot of the total size, which may be outdated by the time it returns.
+    auto size() const -> std::size_t
+    {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < _shard_count; ++i)
+        {
+            const std::lock_guard lock(_shards[i].mutex);
+            total += _shards[i].heap.size();
+        }
+        return total;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    auto shard_count() const -> std::size_t
+    {
+        return _shard_count;
+    }
+
+public: // Modifiers
+    void push(const T& value)
+    {
+        Shard& shard = shard_of(value.unique_id());
+        const std::lock_guard lock(shard.mutex);
+        shard.heap.push(value);
+    }
+
+    void push(T&& value)
+    {
+        Shard& shard = shard_of(value.unique_id());
+        const std::lock_guard lock(shard.mutex);
+        shard.heap.push(std::move(value));
+    }
+
+    /// @brief Pops the better top of two random shards.
+    /// Falls back to the first non-empty shard if sampling keeps failing, so that it only fails if every shard is.
+    /// @return popped value, `std::nullopt` if the queue was empty
+    auto try_pop() -> std::optional<T>
+    {
+        if (_shard_count == 1)
+            return pop_from(_shards[0]);
+
+        auto& rand = thread_rand();
+        std::uniform_int_distribution<std::size_t> shard_dist(0, _shard_count - 1);
+
+        for (int attempt = 0; attempt < MAX_SAMPLE_ATTEMPTS; ++attempt)
+        {
+            const std::size_t first = shard_dist(rand);
+            std::size_t second = shard_dist(rand);
+            if (second == first)
+                second = (second + 1) % _shard_count;
+
+            // never block while holding a lock, so that threads sampling the same pair in reverse can't deadlock
+            std::unique_lock first_lock(_shards[first].mutex, std::try_to_lock);
+            if (!first_lock)
+                continue;
+            std::unique_lock second_lock(_shards[second].mutex, std::try_to_lock);
+
+            Heap* best = _shards[first].heap.empty() ? nullptr : &_shards[first].heap;
+            if (second_lock && !_shards[second].heap.empty())
+                if (!best || Compare{}(best->top(), _shards[second].heap.top()))
+                    best = &_shards[second].heap;
+
+            if (best)
+                return pop_top(*best);
+        }
+
+        const std::size_t start = shard_dist(rand);
+        for (std::size_t i = 0; i < _shard_count; ++i)
+            if (auto value = pop_from(_shards[(start + i) % _shard_count]))
+                return value;
+        return std::nullopt;
+    }
+
+    /// @return whether `id` was found and erased
+    bool erase(const UniqueId& id)
+    {
+        Shard& shard = shard_of(id);
+        const std::lock_guard lock(shard.mutex);
+        return shard.heap.erase(id);
+    }
+
+    /// @brief `AlterBinaryHeap::modify()` under the lock of the shard owning `id`.
+    /// @return whether `id` was found
+    template <typename Fn>
+    bool modify(const UniqueId& id, Fn&& fn)
+    {
+        Shard& shard = shard_of(id);
+        const std::lock_guard lock(shard.mutex);
+        return shard.heap.modify(id, std::forward<Fn>(fn));
+    }
+
+public: // Lookup
+    /// @return copy of the value of `id`, as it may be popped as soon as the lock is released
+    auto find(const UniqueId& id) const -> std::optional<T>
+    {
+        const Shard& shard = shard_of(id);
+        const std::lock_guard lock(shard.mutex);
+
+        const auto it = shard.heap.find(id);
+        if (it == shard.heap.cend())
+            return std::nullopt;
+        return *it;
+    }
+
+private:
+    auto pop_from(Shard& shard) -> std::optional<T>
+    {
+        const std::lock_guard lock(shard.mutex);
+        if (shard.heap.empty())
+            return std::nullopt;
+        return pop_top(shard.heap);
+    }
+
+    /// @brief Pops the top of a non-empty `heap`, moved out rather than copied before `pop()`
+    static auto pop_top(Heap& heap) -> std::optional<T>
+    {
+        std::optional<T> value;
+        heap.pop_k(1, OptionalOutput{&value});
+        return value;
+    }
+
+    auto shard_index(const UniqueId& id) const -> std::size_t
+    {
+        // Fibonacci hashing, which spreads the identity hashes of integers, then multiply-shift range reduction
+        const auto hash = static_cast<std::uint64_t>(UniqueIdHash{}(id)) * UINT64_C(0x9E3779B97F4A7C15);
+        return ((hash >> 32) * _shard_count) >> 32;
+    }
+
+    auto shard_of(const UniqueId& id) -> Shard&
+    {
+        return _shards[shard_index(id)];
+    }
+
+    auto shard_of(const UniqueId& id) const -> const Shard&
+    {
+        return _shards[shard_index(id)];
+    }
+
+    static auto thread_rand() -> std::minstd_rand&
+    {
+        thread_local std::minstd_rand rand(std::random_device{}());
+        return rand;
+    }
+
+public:
+    /// @brief Checks every shard, and that every value lives in the shard owning its id.
+    /// Locks the shards one by one, so it's only meaningful while no other thread modifies the queue.
+    bool validate() const
+    {
+        for (std::size_t i = 0; i < _shard_count; ++i)
+        {
+            const std::lock_guard lock(_shards[i].mutex);
+
+            const Heap& heap = _shards[i].heap;
+            if (!heap.validate())
+                return false;
+            if (!std::all_of(heap.begin(), heap.end(),
+                             [this, i](const T& value) { return shard_index(value.unique_id()) == i; }))
+                return false;
+        }
+        return true;
+    }
+
+private:
+    std::size_t _shard_count;
+    std::unique_ptr<Shard[]> _shards;
+};
+
+} // namespace bs
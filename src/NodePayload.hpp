@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#include "TraversalInfo.hpp"
+
+namespace bs
+{
+
+/// @brief Key & value of a tree node.
+/// Specialized on `Value = void` for sets, whose nodes store the key only.
+template <typename Key, typename Value>
+struct NodePayload
+{
+    template <typename TKey, typename... TValArgs>
+    constexpr NodePayload(TKey&& key_, TValArgs&&... val_args)
+        : key(std::forward<TKey>(key_)), value(std::forward<TValArgs>(val_args)...)
+    {
+    }
+
+    Key key;
+    Value value;
+
+public:
+    static constexpr std::size_t MEMBER_BYTES = sizeof(Key) + sizeof(Value);
+
+    /// @brief What `find()` points to.
+    constexpr auto mapped() -> Value&
+    {
+        return value;
+    }
+
+    constexpr auto mapped() const -> const Value&
+    {
+        return value;
+    }
+
+    /// @brief Calls a traversal callback, `op(key, value, info)`.
+    template <typename Operation>
+    constexpr void visit(Operation& op, const TraversalInfo& info)
+    {
+        op(key, value, info);
+    }
+
+    template <typename Operation>
+    constexpr void visit(Operation& op, const TraversalInfo& info) const
+    {
+        op(key, value, info);
+    }
+};
+
+template <typename Key>
+struct NodePayload<Key, void>
+{
+    template <typename TKey>
+    constexpr explicit NodePayload(TKey&& key_) : key(std::forward<TKey>(key_))
+    {
+    }
+
+    Key key;
+
+public:
+    static constexpr std::size_t MEMBER_BYTES = sizeof(Key);
+
+    /// @brief What `find()` points to, the key itself as there's no value.
+    constexpr auto mapped() const -> const Key&
+    {
+        return key;
+    }
+
+    /// @brief Calls a traversal callback, `op(key, info)`.
+    template <typename Operation>
+    constexpr void visit(Operation& op, const TraversalInfo& info) const
+    {
+        op(key, info);
+    }
+};
+
+} // namespace bs
@@ -0,0 +1,23 @@
+#pragma once
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+namespace bs
+{
+
+/// @brief Hints the CPU to start loading `addr` into the cache, without waiting for it.
+/// No-op where the compiler has no prefetch intrinsic.
+inline void prefetch(const void* addr)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(addr);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_prefetch(static_cast<const char*>(addr), _MM_HINT_T0);
+#else
+    (void)addr;
+#endif
+}
+
+} // namespace bs
@@ -1,65 +1,85 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <span>
 #include <stdexcept>
-
+#include <type_traits>
+#include <utility>
+
+#include "FlatTable.hpp"
+#include "KeyPolicy.hpp"
+#include "MemoryUsage.hpp"
+#include "NodePayload.hpp"
+#include "Prefetch.hpp"
 #include "TraversalInfo.hpp"
 
 namespace bs
 {
 
-template <typename Key, typename Value, typename Compare = std::less<Key>>
+/// @brief Red-black tree.
+///
+/// Everything but `find_many()` and the memory accounting is `constexpr`,
+/// so a tree can be built and queried at compile time, and kept with `to_flat_table()`.
+///
+/// With `MultiKeys`, equal keys are stored in separate nodes, in insertion order.
+/// With `Value = void` (`RBSet`), nodes store the key only, and traversal callbacks are `op(key, info)`.
+template <typename Key, typename Value, typename Compare = std::less<Key>, typename KeyPolicy = UniqueKeys>
 class RBTree
 {
 private:
-    struct Node
+    // Links & color only, so that the nil node doesn't construct `Key`, `Value`
+    struct NodeBase
     {
-        bool red;
-
-        Node* parent;
-        Node* left;
-        Node* right;
+        NodeBase* parent = nullptr;
+        NodeBase* left = nullptr;
+        NodeBase* right = nullptr;
 
-        Key key;
-        Value value;
+        // last, so that a small key can fit in the tail padding
+        bool red = false;
     };
 
-    // To avoid constructing `Key`, `Value` for nil node
-    struct alignas(alignof(Node)) NilNode
-    {
-        bool red = false;
+    using Payload = NodePayload<Key, Value>;
 
-        Node* parent;
+    struct Node : NodeBase, Payload
+    {
+        template <typename TKey, typename... TValArgs>
+        constexpr Node(bool red_, NodeBase* parent_, NodeBase* nil, TKey&& key_, TValArgs&&... val_args)
+            : NodeBase{.parent = parent_, .left = nil, .right = nil, .red = red_},
+              Payload(std::forward<TKey>(key_), std::forward<TValArgs>(val_args)...)
+        {
+        }
     };
 
 public:
-    RBTree() : _nil_node{.parent = &get_nil()}, _root(&get_nil())
+    /// `Value`, or `const Key` for sets
+    using Mapped = std::remove_reference_t<decltype(std::declval<Payload&>().mapped())>;
+
+public:
+    constexpr RBTree() : _nil_node{.parent = &_nil_node}, _root(&_nil_node), _finger(&_nil_node)
     {
     }
 
-    ~RBTree()
+    constexpr ~RBTree()
     {
         clear();
     }
 
 public:
-    // Doesn't insert if same key present
+    // Doesn't insert if same key present, unless `MultiKeys`
     template <typename TKey, typename... TValArgs>
-    bool insert(TKey&& key, TValArgs&&... val_args)
+    constexpr bool insert(TKey&& key, TValArgs&&... val_args)
     {
         if (is_nil(*_root))
         {
-            _root = new Node{
-                .red = false,
-                .parent = &get_nil(),
-                .left = &get_nil(),
-                .right = &get_nil(),
-                .key = std::forward<TKey>(key),
-                .value = Value(std::forward<TValArgs>(val_args)...),
-            };
+            _root = new Node(false, &get_nil(), &get_nil(), std::forward<TKey>(key),
+                             std::forward<TValArgs>(val_args)...);
             _size += 1;
+            _peak_size = std::max(_peak_size, _size);
             return true;
         }
 
@@ -70,19 +90,15 @@ public:
 
     // Overwrite if same key present
     template <typename TKey, typename... TValArgs>
-    bool insert_or_assign(TKey&& key, TValArgs&&... val_args)
+        requires(!KeyPolicy::ALLOW_DUPLICATES && !std::is_void_v<Value>)
+    constexpr bool insert_or_assign(TKey&& key, TValArgs&&... val_args)
     {
         if (is_nil(*_root))
         {
-            _root = new Node{
-                .red = false,
-                .parent = &get_nil(),
-                .left = &get_nil(),
-                .right = &get_nil(),
-                .key = std::forward<TKey>(key),
-                .value = Value(std::forward<TValArgs>(val_args)...),
-            };
+            _root = new Node(false, &get_nil(), &get_nil(), std::forward<TKey>(key),
+                             std::forward<TValArgs>(val_args)...);
             _size += 1;
+            _peak_size = std::max(_peak_size, _size);
             return true;
         }
 
@@ -91,162 +107,254 @@ public:
         return inserted;
     }
 
-    bool erase(const Key& key)
+    /// @brief Erases every node of `key`.
+    constexpr bool erase(const Key& key)
     {
-        const bool erased = erase_recurse(*_root, key);
+        NodeBase* last_visited = _root;
+        bool erased = false;
+        while (erase_node(descend(*_root, key, last_visited)))
+        {
+            erased = true;
+            if constexpr (!KeyPolicy::ALLOW_DUPLICATES)
+                break;
+        }
         return erased;
     }
 
-    auto find(const Key& key) -> Value*
+    /// @brief Finds the first inserted one of equal keys.
+    /// Starts from the last found node if `key` is a few levels away from it,
+    /// so repeated and nearby lookups skip the descent from the root.
+    constexpr auto find(const Key& key) -> Mapped*
     {
-        Node& node = find_recurse(*_root, key);
+        NodeBase* last_visited = _finger;
+        NodeBase& node = descend(*finger_start(_finger, key, FINGER_MAX_CLIMB), key, last_visited);
         if (is_nil(node))
             return nullptr;
-        return &node.value;
+
+        _finger = &node;
+        return &as_node(node).mapped();
     }
 
-    auto find(const Key& key) const -> const Value*
+    /// @brief Unlike the non-const `find()`, this doesn't use nor update the last found node,
+    /// so it's safe to call concurrently.
+    constexpr auto find(const Key& key) const -> const Mapped*
     {
-        const Node& node = find_recurse(*_root, key);
+        NodeBase* last_visited = _root;
+        const NodeBase& node = descend(*_root, key, last_visited);
         if (is_nil(node))
             return nullptr;
-        return &node.value;
+        return &as_node(node).mapped();
+    }
+
+    /// @brief Batched `find()`, `out[i] = find(keys[i])`.
+    /// Descends `FIND_MANY_LANES` lookups at once, one level at a time,
+    /// and prefetches each child before switching to the next lookup, so that their cache misses overlap.
+    void find_many(std::span<const Key> keys, std::span<Mapped*> out)
+    {
+        find_many_impl(keys, out);
+    }
+
+    void find_many(std::span<const Key> keys, std::span<const Mapped*> out) const
+    {
+        find_many_impl(keys, out);
+    }
+
+    /// @brief Batched `find()` for sorted `keys`, `out[i] = find(keys[i])`.
+    /// Each lookup climbs from the previous result (finger) up to the subtree that covers the next key,
+    /// instead of descending from the root, which costs O(k log(n/k)) for k keys.
+    /// Both ascending and descending `keys` work; unsorted `keys` are still correct, just slower.
+    constexpr void find_sorted_batch(std::span<const Key> keys, std::span<Mapped*> out)
+    {
+        find_sorted_batch_impl(keys, out);
+    }
+
+    constexpr void find_sorted_batch(std::span<const Key> keys, std::span<const Mapped*> out) const
+    {
+        find_sorted_batch_impl(keys, out);
+    }
+
+    constexpr auto count(const Key& key) const -> std::size_t
+    {
+        std::size_t result = 0;
+        equal_range(key, [&result](const auto&...) { ++result; });
+        return result;
+    }
+
+    /// @brief Calls `op(key, value, info)`, or `op(key, info)` for sets, on every node of `key`, in insertion order.
+    /// Visits O(log n + count(key)) nodes.
+    template <typename Operation>
+    constexpr void equal_range(const Key& key, Operation op)
+    {
+        equal_range_recurse(*_root, key, op, 0);
+    }
+
+    template <typename Operation>
+    constexpr void equal_range(const Key& key, Operation op) const
+    {
+        equal_range_recurse(std::as_const(*_root), key, op, 0);
     }
 
 public:
     template <typename Operation>
-    void preorder(Operation op)
+    constexpr void preorder(Operation op)
     {
         preorder_recurse(*_root, op, 0);
     }
 
     template <typename Operation>
-    void preorder(Operation op) const
+    constexpr void preorder(Operation op) const
     {
-        preorder_recurse(*_root, op, 0);
+        preorder_recurse(std::as_const(*_root), op, 0);
     }
 
     template <typename Operation>
-    void inorder(Operation op)
+    constexpr void inorder(Operation op)
     {
         inorder_recurse(*_root, op, 0);
     }
 
     template <typename Operation>
-    void inorder(Operation op) const
+    constexpr void inorder(Operation op) const
     {
-        inorder_recurse(*_root, op, 0);
+        inorder_recurse(std::as_const(*_root), op, 0);
     }
 
     template <typename Operation>
-    void postorder(Operation op)
+    constexpr void postorder(Operation op)
     {
         postorder_recurse(*_root, op, 0);
     }
 
     template <typename Operation>
-    void postorder(Operation op) const
+    constexpr void postorder(Operation op) const
     {
-        postorder_recurse(*_root, op, 0);
+        postorder_recurse(std::as_const(*_root), op, 0);
+    }
+
+    /// @brief Copies the key-value pairs in key order, e.g. to keep a tree built at compile time:
+    /// ```
+    /// constexpr auto TABLE = [] {
+    ///     bs::RBTree<int, int> tree;
+    ///     tree.insert(1, 10);
+    ///     tree.insert(2, 20);
+    ///     return tree.to_flat_table<2>();
+    /// }();
+    /// ```
+    /// @throw std::length_error if `N != size()`, which fails the compilation in a constant expression
+    template <std::size_t N>
+        requires(!std::is_void_v<Value>)
+    constexpr auto to_flat_table() const -> FlatTable<Key, Value, N, Compare>
+    {
+        if (N != _size)
+            throw std::length_error("`N` should be the size of the tree");
+
+        FlatTable<Key, Value, N, Compare> table;
+        std::size_t index = 0;
+        inorder([&table, &index](const Key& key, const Value& value, [[maybe_unused]] const TraversalInfo& info) {
+            table.entries[index++] = {key, value};
+        });
+        return table;
     }
 
 public:
-    bool empty() const
+    constexpr bool empty() const
     {
         return _size == 0;
     }
 
-    size_t size() const
+    constexpr size_t size() const
     {
         return _size;
     }
 
 public:
-    void clear()
+    auto memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(_size);
+    }
+
+    /// @brief Memory usage at the largest size since construction or the last `reset_peak()`.
+    auto peak_memory_usage() const -> MemoryUsage
+    {
+        return memory_usage_of(_peak_size);
+    }
+
+    void reset_peak()
+    {
+        _peak_size = _size;
+    }
+
+public:
+    constexpr void clear()
     {
         clear_recurse(*_root);
         _root = &get_nil();
+        _finger = &get_nil();
         _size = 0;
     }
 
 private:
     template <typename TKey, typename... TValArgs>
-    bool insert_recurse(Node& cur, const bool assign, TKey&& key, TValArgs&&... val_args)
+    constexpr bool insert_recurse(NodeBase& cur, const bool assign, TKey&& key, TValArgs&&... val_args)
     {
-        if (less(key, cur.key))
+        if (less(key, key_of(cur)))
         {
             if (!is_nil(*cur.left))
-                return insert_recurse(*cur.left, assign, std::forward<TKey>(key), std::forward<TValArgs>(val_args)...);
+                return insert_recurse(*cur.left, assign, std::forward<TKey>(key),
+                                      std::forward<TValArgs>(val_args)...);
             else
             {
-                cur.left = new Node{
-                    .red = true,
-                    .parent = &cur,
-                    .left = &get_nil(),
-                    .right = &get_nil(),
-                    .key = std::forward<TKey>(key),
-                    .value = Value(std::forward<TValArgs>(val_args)...),
-                };
+                cur.left = new Node(true, &cur, &get_nil(), std::forward<TKey>(key),
+                                    std::forward<TValArgs>(val_args)...);
                 _size += 1;
+                _peak_size = std::max(_peak_size, _size);
                 rebalance_insert(*cur.left);
                 return true;
             }
         }
-        else if (greater(key, cur.key))
+        else if (KeyPolicy::ALLOW_DUPLICATES || greater(key, key_of(cur)))
         {
             if (!is_nil(*cur.right))
-                return insert_recurse(*cur.right, assign, std::forward<TKey>(key), std::forward<TValArgs>(val_args)...);
+                return insert_recurse(*cur.right, assign, std::forward<TKey>(key),
+                                      std::forward<TValArgs>(val_args)...);
             else
             {
-                cur.right = new Node{
-                    .red = true,
-                    .parent = &cur,
-                    .left = &get_nil(),
-                    .right = &get_nil(),
-                    .key = std::forward<TKey>(key),
-                    .value = Value(std::forward<TValArgs>(val_args)...),
-                };
+                cur.right = new Node(true, &cur, &get_nil(), std::forward<TKey>(key),
+                                     std::forward<TValArgs>(val_args)...);
                 _size += 1;
+                _peak_size = std::max(_peak_size, _size);
                 rebalance_insert(*cur.right);
                 return true;
             }
         }
         // equal
 
-        if (assign)
-            cur.value = Value(std::forward<TValArgs>(val_args)...);
+        if constexpr (!std::is_void_v<Value>)
+            if (assign)
+                as_node(cur).value = Value(std::forward<TValArgs>(val_args)...);
         return false;
     }
 
-    bool erase_recurse(Node& cur, const Key& key)
+    constexpr bool erase_node(NodeBase& cur)
     {
         if (is_nil(cur))
             return false;
 
-        if (less(key, cur.key))
-            return erase_recurse(*cur.left, key);
-        if (greater(key, cur.key))
-            return erase_recurse(*cur.right, key);
-        // equal
-        return erase_node(cur);
-    }
-
-    bool erase_node(Node& cur)
-    {
-        if (is_nil(cur))
-            return false;
+        // `cur` or its in-order neighbor is about to be deleted
+        _finger = &get_nil();
 
         // 2 children
         if (!is_nil(*cur.left) && !is_nil(*cur.right))
         {
             // find the right-most node in the left subtree
-            Node* right_most = cur.left;
+            NodeBase* right_most = cur.left;
             while (!is_nil(*right_most->right))
                 right_most = right_most->right;
 
             // move the key & value to `cur`
-            cur.key = std::move(right_most->key);
-            cur.value = std::move(right_most->value);
+            as_node(cur).key = std::move(as_node(*right_most).key);
+            if constexpr (!std::is_void_v<Value>)
+                as_node(cur).value = std::move(as_node(*right_most).value);
 
             // remove `right_most`
             if (!erase_node(*right_most))
@@ -256,8 +364,8 @@ private:
         // 1 or 0 child
         else
         {
-            Node& child = (!is_nil(*cur.left)) ? *cur.left : *cur.right;
-            Node& parent = *cur.parent;
+            NodeBase& child = (!is_nil(*cur.left)) ? *cur.left : *cur.right;
+            NodeBase& parent = *cur.parent;
 
             if (is_nil(parent)) // `cur` is root
                 _root = &child;
@@ -272,147 +380,273 @@ private:
             if (!cur.red)
                 rebalance_erase(child);
 
-            delete &cur;
+            delete &as_node(cur);
         }
 
         _size -= 1;
         return true;
     }
 
-    auto find_recurse(Node& cur, const Key& key) -> Node&
+private:
+    template <typename ValuePtr>
+    constexpr void find_sorted_batch_impl(std::span<const Key> keys, std::span<ValuePtr> out) const
     {
-        if (is_nil(cur))
-            return get_nil();
+        assert(keys.size() == out.size());
 
-        if (less(key, cur.key))
-            return find_recurse(*cur.left, key);
-        if (greater(key, cur.key))
-            return find_recurse(*cur.right, key);
-        // equal
-        return cur;
+        NodeBase* finger = nullptr;
+        for (std::size_t i = 0; i < keys.size(); ++i)
+        {
+            NodeBase& node = descend(*finger_start(finger, keys[i], SIZE_MAX), keys[i], finger);
+            out[i] = is_nil(node) ? nullptr : &as_node(node).mapped();
+        }
     }
 
-    auto find_recurse(const Node& cur, const Key& key) const -> const Node&
+    /// @brief Climbs from `finger` to the lowest ancestor whose subtree may contain `key`.
+    /// @return the ancestor, or `_root` if `finger` is null or nil, or it'd take more than `max_climb` steps
+    constexpr auto finger_start(NodeBase* finger, const Key& key, std::size_t max_climb) const -> NodeBase*
     {
-        if (is_nil(cur))
-            return get_nil();
+        if (!finger || is_nil(*finger))
+            return _root;
+
+        const bool ascending = greater(key, key_of(*finger));
+        const bool descending = less(key, key_of(*finger));
+        if (!ascending && !descending)
+        {
+            // the first one of equal keys might be anywhere
+            if constexpr (KeyPolicy::ALLOW_DUPLICATES)
+                return _root;
+            return finger;
+        }
+
+        // The subtree of `cur` always contains `finger`, which bounds one side of `key`.
+        // The other side is bounded once `cur` hangs on the matching side of a parent on the far side of `key`.
+        NodeBase* cur = finger;
+        for (std::size_t climbed = 0; !is_nil(*cur->parent); ++climbed)
+        {
+            const NodeBase& parent = *cur->parent;
+            if (ascending && cur == parent.left && less(key, key_of(parent)))
+                break;
+            if (descending && cur == parent.right && greater(key, key_of(parent)))
+                break;
+
+            if (climbed == max_climb)
+                return _root;
+            cur = cur->parent;
+        }
 
-        if (less(key, cur.key))
-            return find(*cur.left, key);
-        if (greater(key, cur.key))
-            return find(*cur.right, key);
-        // equal
         return cur;
     }
 
+    /// @param[out] last_visited last non-nil node on the way, left untouched if `start` is nil
+    /// @return first inserted node of `key`, or nil if not found
+    constexpr auto descend(NodeBase& start, const Key& key, NodeBase*& last_visited) const -> NodeBase&
+    {
+        NodeBase* cur = &start;
+        NodeBase* found = nullptr;
+        while (!is_nil(*cur))
+        {
+            last_visited = cur;
+
+            if (less(key, key_of(*cur)))
+                cur = cur->left;
+            else if (greater(key, key_of(*cur)))
+                cur = cur->right;
+            else if constexpr (KeyPolicy::ALLOW_DUPLICATES)
+            {
+                // earlier ones can only be on the left
+                found = cur;
+                cur = cur->left;
+            }
+            else
+                return *cur;
+        }
+        return found ? *found : *cur;
+    }
+
+    template <typename ValuePtr>
+    void find_many_impl(std::span<const Key> keys, std::span<ValuePtr> out) const
+    {
+        assert(keys.size() == out.size());
+
+        struct Lane
+        {
+            NodeBase* node;
+            std::size_t key_index;
+            /// first inserted node of the key so far, with `MultiKeys`
+            NodeBase* found = nullptr;
+        };
+
+        std::array<Lane, FIND_MANY_LANES> lanes;
+        std::size_t lane_count = 0;
+        std::size_t next_key_index = 0;
+
+        // `_root` stays hot in cache, no need to prefetch it
+        while (lane_count < lanes.size() && next_key_index < keys.size())
+            lanes[lane_count++] = Lane{.node = _root, .key_index = next_key_index++};
+
+        while (lane_count > 0)
+        {
+            for (std::size_t i = 0; i < lane_count;)
+            {
+                Lane& lane = lanes[i];
+                NodeBase& cur = *lane.node;
+                const Key& key = keys[lane.key_index];
+
+                bool finished = true;
+                if (is_nil(cur))
+                    out[lane.key_index] = lane.found ? &as_node(*lane.found).mapped() : nullptr;
+                else if (less(key, key_of(cur)))
+                {
+                    lane.node = cur.left;
+                    finished = false;
+                }
+                else if (greater(key, key_of(cur)))
+                {
+                    lane.node = cur.right;
+                    finished = false;
+                }
+                else if constexpr (KeyPolicy::ALLOW_DUPLICATES)
+                {
+                    lane.found = &cur;
+                    lane.node = cur.left;
+                    finished = false;
+                }
+                else
+                    out[lane.key_index] = &as_node(cur).mapped();
+
+                if (!finished)
+                {
+                    prefetch(lane.node);
+                    ++i;
+                    continue;
+                }
+
+                // start the next lookup on this lane, or retire it
+                if (next_key_index < keys.size())
+                {
+                    lane = Lane{.node = _root, .key_index = next_key_index++};
+                    ++i;
+                }
+                else
+                    lane = lanes[--lane_count];
+            }
+        }
+    }
+
 private:
     template <typename Operation>
-    void preorder_recurse(Node& cur, Operation op, std::size_t complete_index)
+    constexpr void equal_range_recurse(NodeBase& cur, const Key& key, Operation& op, std::size_t complete_index)
     {
         if (is_nil(cur))
             return;
 
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = cur.red,
-           });
-        preorder_recurse(*cur.left, op, complete_index * 2 + 1);
-        preorder_recurse(*cur.right, op, complete_index * 2 + 2);
+        // equal keys may lie on both sides, as rotations move them around
+        if (!less(key_of(cur), key))
+            equal_range_recurse(*cur.left, key, op, complete_index * 2 + 1);
+        if (equal(key, key_of(cur)))
+            as_node(cur).visit(op, TraversalInfo{.complete_index = complete_index, .red = cur.red});
+        if (!greater(key_of(cur), key))
+            equal_range_recurse(*cur.right, key, op, complete_index * 2 + 2);
+    }
+
+    template <typename Operation>
+    constexpr void equal_range_recurse(const NodeBase& cur, const Key& key, Operation& op,
+                                       std::size_t complete_index) const
+    {
+        if (is_nil(cur))
+            return;
+
+        if (!less(key_of(cur), key))
+            equal_range_recurse(std::as_const(*cur.left), key, op, complete_index * 2 + 1);
+        if (equal(key, key_of(cur)))
+            as_node(cur).visit(op, TraversalInfo{.complete_index = complete_index, .red = cur.red});
+        if (!greater(key_of(cur), key))
+            equal_range_recurse(std::as_const(*cur.right), key, op, complete_index * 2 + 2);
     }
 
     template <typename Operation>
-    void preorder_recurse(Node& cur, Operation op, std::size_t complete_index) const
+    constexpr void preorder_recurse(NodeBase& cur, Operation& op, std::size_t complete_index)
     {
         if (is_nil(cur))
             return;
 
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = cur.red,
-           });
+        as_node(cur).visit(op, TraversalInfo{.complete_index = complete_index, .red = cur.red});
         preorder_recurse(*cur.left, op, complete_index * 2 + 1);
         preorder_recurse(*cur.right, op, complete_index * 2 + 2);
     }
 
     template <typename Operation>
-    void inorder_recurse(Node& cur, Operation op, std::size_t complete_index)
+    constexpr void preorder_recurse(const NodeBase& cur, Operation& op, std::size_t complete_index) const
     {
         if (is_nil(cur))
             return;
 
-        inorder_recurse(*cur.left, op, complete_index * 2 + 1);
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = cur.red,
-           });
-        inorder_recurse(*cur.right, op, complete_index * 2 + 2);
+        as_node(cur).visit(op, TraversalInfo{.complete_index = complete_index, .red = cur.red});
+        preorder_recurse(std::as_const(*cur.left), op, complete_index * 2 + 1);
+        preorder_recurse(std::as_const(*cur.right), op, complete_index * 2 + 2);
     }
 
     template <typename Operation>
-    void inorder_recurse(Node& cur, Operation op, std::size_t complete_index) const
+    constexpr void inorder_recurse(NodeBase& cur, Operation& op, std::size_t complete_index)
     {
         if (is_nil(cur))
             return;
 
         inorder_recurse(*cur.left, op, complete_index * 2 + 1);
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = cur.red,
-           });
+        as_node(cur).visit(op, TraversalInfo{.complete_index = complete_index, .red = cur.red});
         inorder_recurse(*cur.right, op, complete_index * 2 + 2);
     }
 
     template <typename Operation>
-    void postorder_recurse(Node& cur, Operation op, std::size_t complete_index)
+    constexpr void inorder_recurse(const NodeBase& cur, Operation& op, std::size_t complete_index) const
     {
         if (is_nil(cur))
             return;
 
-        postorder_recurse(*cur.left, op, complete_index * 2 + 1);
-        postorder_recurse(*cur.right, op, complete_index * 2 + 2);
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = cur.red,
-           });
+        inorder_recurse(std::as_const(*cur.left), op, complete_index * 2 + 1);
+        as_node(cur).visit(op, TraversalInfo{.complete_index = complete_index, .red = cur.red});
+        inorder_recurse(std::as_const(*cur.right), op, complete_index * 2 + 2);
     }
 
     template <typename Operation>
-    void postorder_recurse(Node& cur, Operation op, std::size_t complete_index) const
+    constexpr void postorder_recurse(NodeBase& cur, Operation& op, std::size_t complete_index)
     {
         if (is_nil(cur))
             return;
 
         postorder_recurse(*cur.left, op, complete_index * 2 + 1);
         postorder_recurse(*cur.right, op, complete_index * 2 + 2);
-        op(cur.key, cur.value,
-           TraversalInfo{
-               .complete_index = complete_index,
-               .red = cur.red,
-           });
+        as_node(cur).visit(op, TraversalInfo{.complete_index = complete_index, .red = cur.red});
     }
 
-    void clear_recurse(Node& cur)
+    template <typename Operation>
+    constexpr void postorder_recurse(const NodeBase& cur, Operation& op, std::size_t complete_index) const
+    {
+        if (is_nil(cur))
+            return;
+
+        postorder_recurse(std::as_const(*cur.left), op, complete_index * 2 + 1);
+        postorder_recurse(std::as_const(*cur.right), op, complete_index * 2 + 2);
+        as_node(cur).visit(op, TraversalInfo{.complete_index = complete_index, .red = cur.red});
+    }
+
+    constexpr void clear_recurse(NodeBase& cur)
     {
         if (is_nil(cur))
             return;
 
         clear_recurse(*cur.left);
         clear_recurse(*cur.right);
-        delete &cur;
+        delete &as_node(cur);
     }
 
 private:
-    void rebalance_insert(Node& cur)
+    constexpr void rebalance_insert(NodeBase& cur)
     {
         assert(!is_nil(cur));
         assert(cur.red);
 
-        Node& parent = *cur.parent;
+        NodeBase& parent = *cur.parent;
         // If root, recolor to black
         if (&cur == _root)
         {
@@ -428,14 +662,14 @@ private:
 
         // parent is red
         // grand is black
-        Node& grand = *parent.parent;
+        NodeBase& grand = *parent.parent;
         assert(!is_nil(grand));
         assert(!grand.red);
 
         const bool cur_is_left = (&cur == parent.left);
         const bool parent_is_left = (&parent == grand.left);
 
-        Node& uncle = parent_is_left ? *grand.right : *grand.left;
+        NodeBase& uncle = parent_is_left ? *grand.right : *grand.left;
 
         // 1. parent: red, uncle: red
         if (uncle.red)
@@ -477,7 +711,7 @@ private:
     }
 
     /// @param child starts with erased node's child
-    void rebalance_erase(Node& child)
+    constexpr void rebalance_erase(NodeBase& child)
     {
         // 0. if root, recolor it to black
         if (&child == _root)
@@ -486,10 +720,10 @@ private:
             return;
         }
 
-        Node& parent = *child.parent;
+        NodeBase& parent = *child.parent;
 
         const bool child_is_left = (&child == parent.left);
-        Node& sibling = child_is_left ? *parent.right : *parent.left;
+        NodeBase& sibling = child_is_left ? *parent.right : *parent.left;
 
         // 1. child: red
         if (child.red)
@@ -557,12 +791,12 @@ private:
     }
 
 private:
-    void rotate_left(Node& cur)
+    constexpr void rotate_left(NodeBase& cur)
     {
         assert(!is_nil(cur));
 
-        Node& parent = *cur.parent;
-        Node& right = *cur.right;
+        NodeBase& parent = *cur.parent;
+        NodeBase& right = *cur.right;
         assert(!is_nil(right));
 
         cur.right = right.left;
@@ -584,12 +818,12 @@ private:
         }
     }
 
-    void rotate_right(Node& cur)
+    constexpr void rotate_right(NodeBase& cur)
     {
         assert(!is_nil(cur));
 
-        Node& parent = *cur.parent;
-        Node& left = *cur.left;
+        NodeBase& parent = *cur.parent;
+        NodeBase& left = *cur.left;
         assert(!is_nil(left));
 
         cur.left = left.right;
@@ -612,44 +846,77 @@ private:
     }
 
 private:
-    bool is_nil(const Node& node) const
+    constexpr bool is_nil(const NodeBase& node) const
     {
-        return &node == &get_nil();
+        return &node == &_nil_node;
     }
 
-    auto get_nil() const -> const Node&
+    constexpr auto get_nil() const -> const NodeBase&
     {
-        return reinterpret_cast<const Node&>(_nil_node);
+        return _nil_node;
     }
 
-    auto get_nil() -> Node&
+    constexpr auto get_nil() -> NodeBase&
     {
-        return reinterpret_cast<Node&>(_nil_node);
+        return _nil_node;
+    }
+
+    /// @param base non-nil node
+    /// @note Don't store `&as_node(x)` back into the links,
+    /// GCC's constant evaluator then fails to `delete` that node.
+    static constexpr auto as_node(NodeBase& base) -> Node&
+    {
+        return static_cast<Node&>(base);
+    }
+
+    /// @param base non-nil node
+    static constexpr auto as_node(const NodeBase& base) -> const Node&
+    {
+        return static_cast<const Node&>(base);
+    }
+
+    /// @param base non-nil node
+    static constexpr auto key_of(const NodeBase& base) -> const Key&
+    {
+        return as_node(base).key;
+    }
+
+private:
+    auto memory_usage_of(std::size_t node_count) const -> MemoryUsage
+    {
+        constexpr std::size_t MEMBER_BYTES = sizeof(bool) + 3 * sizeof(NodeBase*) + Payload::MEMBER_BYTES;
+
+        return MemoryUsage{
+            .node_count = node_count,
+            .node_bytes = node_count * sizeof(Node),
+            .padding_bytes = node_count * (sizeof(Node) - MEMBER_BYTES),
+            .overhead_bytes = node_count * allocation_overhead(sizeof(Node)) + sizeof(*this),
+        };
     }
 
 private:
-    static bool less(const Key& k1, const Key& k2)
+    static constexpr bool less(const Key& k1, const Key& k2)
     {
         return Compare{}(k1, k2);
     }
 
-    static bool greater(const Key& k1, const Key& k2)
+    static constexpr bool greater(const Key& k1, const Key& k2)
     {
         return Compare{}(k2, k1);
     }
 
-    static bool equal(const Key& k1, const Key& k2)
+    static constexpr bool equal(const Key& k1, const Key& k2)
     {
         return !less(k1, k2) && !greater(k1, k2);
     }
 
 public:
-    int black_depth() const
+    constexpr int black_depth() const
     {
         return black_depth_recurse(*_root, 0);
     }
 
-    bool validate() const
+    constexpr bool validate() const
     {
         if (_root->red || get_nil().red)
             return false;
@@ -662,7 +929,7 @@ public:
     }
 
 private:
-    bool validate_no_double_red(const Node& cur) const
+    constexpr bool validate_no_double_red(const NodeBase& cur) const
     {
         if (is_nil(cur))
             return true;
@@ -678,7 +945,7 @@ private:
         return true;
     }
 
-    int black_depth_recurse(const Node& cur, int black_depth) const
+    constexpr int black_depth_recurse(const NodeBase& cur, int black_depth) const
     {
         if (is_nil(cur))
             return black_depth;
@@ -699,11 +966,22 @@ private:
         return left_black_depth;
     }
 
+private:
+    static constexpr std::size_t FIND_MANY_LANES = 16;
+    static constexpr std::size_t FINGER_MAX_CLIMB = 4;
+
 private:
     std::size_t _size = 0;
+    std::size_t _peak_size = 0;
 
-    NilNode _nil_node;
-    Node* _root;
+    NodeBase _nil_node;
+    NodeBase* _root;
+
+    /// last node found by the non-const `find()`
+    NodeBase* _finger;
 };
 
+template <typename Key, typename Compare = std::less<Key>, typename KeyPolicy = UniqueKeys>
+using RBSet = RBTree<Key, void, Compare, KeyPolicy>;
+
 } // namespace bs
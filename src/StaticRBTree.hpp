@@ -0,0 +1,687 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "MemoryUsage.hpp"
+#include "TraversalInfo.hpp"
+
+namespace bs
+{
+
+/// @brief Red-black tree with a fixed capacity of `N` nodes, which never allocates.
+///
+/// Nodes live in an inline array and link each other with 16-bit indices (32-bit if `N` doesn't fit),
+/// unused nodes are chained in a free list.
+/// Mind the stack size when placing a big one on the stack.
+template <typename Key, typename Value, std::size_t N, typename Compare = std::less<Key>>
+class StaticRBTree
+{
+    static_assert(N > 0, "`N` should be positive");
+    static_assert(N < UINT32_MAX, "`N` doesn't fit in 32-bit indices");
+
+public:
+    using Index = std::conditional_t<(N < UINT16_MAX), std::uint16_t, std::uint32_t>;
+
+private:
+    struct Entry
+    {
+        Key key;
+        Value value;
+    };
+
+    struct Node
+    {
+        bool red = false;
+
+        Index parent = NIL;
+        Index left = NIL;
+        Index right = NIL; // next free node, if in the free list
+
+        // constructed only while the node is in use
+        union {
+            Entry entry;
+        };
+
+        Node()
+        {
+        }
+
+        ~Node()
+        {
+        }
+    };
+
+    /// index of the nil node, the first one of `_nodes`
+    static constexpr Index NIL = 0;
+
+public:
+    StaticRBTree()
+    {
+        reset_free_list();
+    }
+
+    ~StaticRBTree()
+    {
+        clear();
+    }
+
+    StaticRBTree(const StaticRBTree&) = delete;
+    StaticRBTree& operator=(const StaticRBTree&) = delete;
+
+public:
+    /// @brief Doesn't insert if same key present
+    /// @throw std::length_error if full and `key` is not present
+    template <typename TKey, typename... TValArgs>
+    bool insert(TKey&& key, TValArgs&&... val_args)
+    {
+        return insert_impl(false, std::forward<TKey>(key), std::forward<TValArgs>(val_args)...);
+    }
+
+    /// @brief Overwrite if same key present
+    /// @throw std::length_error if full and `key` is not present
+    template <typename TKey, typename... TValArgs>
+    bool insert_or_assign(TKey&& key, TValArgs&&... val_args)
+    {
+        return insert_impl(true, std::forward<TKey>(key), std::forward<TValArgs>(val_args)...);
+    }
+
+    bool erase(const Key& key)
+    {
+        return erase_node(find_node(key));
+    }
+
+    auto find(const Key& key) -> Value*
+    {
+        const Index idx = find_node(key);
+        if (idx == NIL)
+            return nullptr;
+        return &_nodes[idx].entry.value;
+    }
+
+    auto find(const Key& key) const -> const Value*
+    {
+        const Index idx = find_node(key);
+        if (idx == NIL)
+            return nullptr;
+        return &_nodes[idx].entry.value;
+    }
+
+public:
+    template <typename Operation>
+    void preorder(Operation op)
+    {
+        preorder_recurse(*this, _root, op, 0);
+    }
+
+    template <typename Operation>
+    void preorder(Operation op) const
+    {
+        preorder_recurse(*this, _root, op, 0);
+    }
+
+    template <typename Operation>
+    void inorder(Operation op)
+    {
+        inorder_recurse(*this, _root, op, 0);
+    }
+
+    template <typename Operation>
+    void inorder(Operation op) const
+    {
+        inorder_recurse(*this, _root, op, 0);
+    }
+
+    template <typename Operation>
+    void postorder(Operation op)
+    {
+        postorder_recurse(*this, _root, op, 0);
+    }
+
+    template <typename Operation>
+    void postorder(Operation op) const
+    {
+        postorder_recurse(*this, _root, op, 0);
+    }
+
+public:
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    bool full() const
+    {
+        return _size == N;
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    static constexpr size_t capacity()
+    {
+        return N;
+    }
+
+public:
+    /// @brief Nothing is allocated, the whole node array is counted in `array_bytes`.
+    auto memory_usage() const -> MemoryUsage
+    {
+        return MemoryUsage{
+            .node_count = _size,
+            .overhead_bytes = sizeof(*this) - sizeof(_nodes),
+            .array_bytes = sizeof(_nodes),
+        };
+    }
+
+public:
+    void clear()
+    {
+        clear_recurse(_root);
+        _root = NIL;
+        _size = 0;
+        reset_free_list();
+    }
+
+private:
+    template <typename TKey, typename... TValArgs>
+    bool insert_impl(const bool assign, TKey&& key, TValArgs&&... val_args)
+    {
+        Index parent = NIL;
+        Index cur = _root;
+        bool go_left = false;
+        while (cur != NIL)
+        {
+            parent = cur;
+            go_left = less(key, key_of(cur));
+            if (go_left)
+                cur = _nodes[cur].left;
+            else if (greater(key, key_of(cur)))
+                cur = _nodes[cur].right;
+            else
+            {
+                if (assign)
+                    _nodes[cur].entry.value = Value(std::forward<TValArgs>(val_args)...);
+                return false;
+            }
+        }
+
+        const Index idx =
+            allocate_node(parent, std::forward<TKey>(key), std::forward<TValArgs>(val_args)...);
+        if (parent == NIL)
+            _root = idx;
+        else if (go_left)
+            _nodes[parent].left = idx;
+        else
+            _nodes[parent].right = idx;
+
+        rebalance_insert(idx);
+        return true;
+    }
+
+    bool erase_node(const Index cur)
+    {
+        if (cur == NIL)
+            return false;
+
+        Node& node = _nodes[cur];
+
+        // 2 children
+        if (node.left != NIL && node.right != NIL)
+        {
+            // find the right-most node in the left subtree
+            Index right_most = node.left;
+            while (_nodes[right_most].right != NIL)
+                right_most = _nodes[right_most].right;
+
+            // move the key & value to `cur`
+            node.entry.key = std::move(_nodes[right_most].entry.key);
+            node.entry.value = std::move(_nodes[right_most].entry.value);
+
+            // remove `right_most`
+            if (!erase_node(right_most))
+                throw std::logic_error("`right_most` should exist, at least `cur.left` exists");
+            return true;
+        }
+        // 1 or 0 child
+        else
+        {
+            const Index child = (node.left != NIL) ? node.left : node.right;
+            const Index parent = node.parent;
+
+            if (parent == NIL) // `cur` is root
+                _root = child;
+            else if (_nodes[parent].left == cur)
+                _nodes[parent].left = child;
+            else
+                _nodes[parent].right = child;
+
+            // set this even if `child` is nil
+            _nodes[child].parent = parent;
+
+            if (!node.red)
+                rebalance_erase(child);
+
+            free_node(cur);
+        }
+
+        return true;
+    }
+
+    auto find_node(const Key& key) const -> Index
+    {
+        Index cur = _root;
+        while (cur != NIL)
+        {
+            if (less(key, key_of(cur)))
+                cur = _nodes[cur].left;
+            else if (greater(key, key_of(cur)))
+                cur = _nodes[cur].right;
+            else
+                return cur;
+        }
+        return NIL;
+    }
+
+private:
+    template <typename TKey, typename... TValArgs>
+    auto allocate_node(const Index parent, TKey&& key, TValArgs&&... val_args) -> Index
+    {
+        const Index idx = _free;
+        if (idx == NIL)
+            throw std::length_error("StaticRBTree is full");
+
+        Node& node = _nodes[idx];
+        std::construct_at(&node.entry, Entry{.key = Key(std::forward<TKey>(key)),
+                                             .value = Value(std::forward<TValArgs>(val_args)...)});
+
+        _free = node.right;
+        node.red = true;
+        node.parent = parent;
+        node.left = NIL;
+        node.right = NIL;
+
+        _size += 1;
+        return idx;
+    }
+
+    void free_node(const Index idx)
+    {
+        Node& node = _nodes[idx];
+        std::destroy_at(&node.entry);
+
+        node.right = _free;
+        _free = idx;
+
+        _size -= 1;
+    }
+
+    void reset_free_list()
+    {
+        for (std::size_t i = 1; i < N; ++i)
+            _nodes[i].right = (Index)(i + 1);
+        _nodes[N].right = NIL;
+        _free = 1;
+
+        _nodes[NIL].red = false;
+        _nodes[NIL].parent = NIL;
+    }
+
+private:
+    template <typename Self, typename Operation>
+    static void preorder_recurse(Self& self, Index cur, Operation& op, std::size_t complete_index)
+    {
+        if (cur == NIL)
+            return;
+
+        auto& node = self._nodes[cur];
+        op(node.entry.key, node.entry.value,
+           TraversalInfo{
+               .complete_index = complete_index,
+               .red = node.red,
+           });
+        preorder_recurse(self, node.left, op, complete_index * 2 + 1);
+        preorder_recurse(self, node.right, op, complete_index * 2 + 2);
+    }
+
+    template <typename Self, typename Operation>
+    static void inorder_recurse(Self& self, Index cur, Operation& op, std::size_t complete_index)
+    {
+        if (cur == NIL)
+            return;
+
+        auto& node = self._nodes[cur];
+        inorder_recurse(self, node.left, op, complete_index * 2 + 1);
+        op(node.entry.key, node.entry.value,
+           TraversalInfo{
+               .complete_index = complete_index,
+               .red = node.red,
+           });
+        inorder_recurse(self, node.right, op, complete_index * 2 + 2);
+    }
+
+    template <typename Self, typename Operation>
+    static void postorder_recurse(Self& self, Index cur, Operation& op, std::size_t complete_index)
+    {
+        if (cur == NIL)
+            return;
+
+        auto& node = self._nodes[cur];
+        postorder_recurse(self, node.left, op, complete_index * 2 + 1);
+        postorder_recurse(self, node.right, op, complete_index * 2 + 2);
+        op(node.entry.key, node.entry.value,
+           TraversalInfo{
+               .complete_index = complete_index,
+               .red = node.red,
+           });
+    }
+
+    void clear_recurse(const Index cur)
+    {
+        if (cur == NIL)
+            return;
+
+        clear_recurse(_nodes[cur].left);
+        clear_recurse(_nodes[cur].right);
+        std::destroy_at(&_nodes[cur].entry);
+    }
+
+private:
+    void rebalance_insert(const Index cur)
+    {
+        assert(cur != NIL);
+        assert(_nodes[cur].red);
+
+        const Index parent = _nodes[cur].parent;
+        // If root, recolor to black
+        if (cur == _root)
+        {
+            assert(parent == NIL);
+            _nodes[cur].red = false;
+            return;
+        }
+        assert(parent != NIL);
+
+        // Do nothing if parent is black
+        if (!_nodes[parent].red)
+            return;
+
+        // parent is red
+        // grand is black
+        const Index grand = _nodes[parent].parent;
+        assert(grand != NIL);
+        assert(!_nodes[grand].red);
+
+        const bool cur_is_left = (cur == _nodes[parent].left);
+        const bool parent_is_left = (parent == _nodes[grand].left);
+
+        const Index uncle = parent_is_left ? _nodes[grand].right : _nodes[grand].left;
+
+        // 1. parent: red, uncle: red
+        if (_nodes[uncle].red)
+        {
+            _nodes[parent].red = false;
+            _nodes[uncle].red = false;
+            _nodes[grand].red = true;
+            rebalance_insert(grand);
+        }
+        // parent: red, uncle: black
+        // 2-1. cur is right, parent is left
+        else if (!cur_is_left && parent_is_left)
+        {
+            rotate_left(parent);
+            rebalance_insert(parent); // go to 3-1 w/ `parent`
+        }
+        // 2-2. cur is left, parent is right
+        else if (cur_is_left && !parent_is_left)
+        {
+            rotate_right(parent);
+            rebalance_insert(parent);
+        }
+        // 3-1. cur is left, parent is left
+        else if (cur_is_left && parent_is_left)
+        {
+            rotate_right(grand);
+            _nodes[parent].red = false;
+            _nodes[grand].red = true;
+        }
+        // 3-2. cur is right, parent is right
+        else if (!cur_is_left && !parent_is_left)
+        {
+            rotate_left(grand);
+            _nodes[parent].red = false;
+            _nodes[grand].red = true;
+        }
+        else
+            throw std::logic_error("Should not reach here");
+    }
+
+    /// @param child starts with erased node's child
+    void rebalance_erase(const Index child)
+    {
+        // 0. if root, recolor it to black
+        if (child == _root)
+        {
+            _nodes[child].red = false;
+            return;
+        }
+
+        const Index parent = _nodes[child].parent;
+
+        const bool child_is_left = (child == _nodes[parent].left);
+        const Index sibling = child_is_left ? _nodes[parent].right : _nodes[parent].left;
+        Node& sib = _nodes[sibling];
+
+        // 1. child: red
+        if (_nodes[child].red)
+        {
+            _nodes[child].red = false;
+            return;
+        }
+        // 2. child: black, sibling: red
+        if (sib.red)
+        {
+            sib.red = false;
+            _nodes[parent].red = true;
+
+            if (child_is_left)
+                rotate_left(parent);
+            else
+                rotate_right(parent);
+
+            rebalance_erase(child);
+        }
+        // 3. child: black, sibling: black, sib_left: black, sib_right: black
+        else if (!_nodes[sib.left].red && !_nodes[sib.right].red)
+        {
+            sib.red = true;
+
+            rebalance_erase(parent);
+        }
+        // 4. child: black, sibling: black, sib_left: red, sib_right: black
+        else if ((child_is_left && (_nodes[sib.left].red && !_nodes[sib.right].red)) ||
+                 (!child_is_left && (_nodes[sib.right].red && !_nodes[sib.left].red)))
+        {
+            sib.red = true;
+
+            if (child_is_left)
+            {
+                _nodes[sib.left].red = false;
+                rotate_right(sibling);
+            }
+            else
+            {
+                _nodes[sib.right].red = false;
+                rotate_left(sibling);
+            }
+
+            rebalance_erase(child);
+        }
+        // 5. child: black, sibling: black, sib_left: ?, sib_right: red
+        else if ((child_is_left && _nodes[sib.right].red) || (!child_is_left && _nodes[sib.left].red))
+        {
+            std::swap(_nodes[parent].red, sib.red);
+
+            if (child_is_left)
+            {
+                _nodes[sib.right].red = false;
+                rotate_left(parent);
+            }
+            else
+            {
+                _nodes[sib.left].red = false;
+                rotate_right(parent);
+            }
+        }
+        else
+            throw std::logic_error("Should not reach here");
+    }
+
+private:
+    void rotate_left(const Index cur)
+    {
+        assert(cur != NIL);
+
+        const Index parent = _nodes[cur].parent;
+        const Index right = _nodes[cur].right;
+        assert(right != NIL);
+
+        _nodes[cur].right = _nodes[right].left;
+        if (_nodes[right].left != NIL)
+            _nodes[_nodes[right].left].parent = cur;
+
+        _nodes[cur].parent = right;
+        _nodes[right].left = cur;
+
+        _nodes[right].parent = parent;
+        if (parent == NIL)
+            _root = right;
+        else
+        {
+            if (_nodes[parent].left == cur)
+                _nodes[parent].left = right;
+            else
+                _nodes[parent].right = right;
+        }
+    }
+
+    void rotate_right(const Index cur)
+    {
+        assert(cur != NIL);
+
+        const Index parent = _nodes[cur].parent;
+        const Index left = _nodes[cur].left;
+        assert(left != NIL);
+
+        _nodes[cur].left = _nodes[left].right;
+        if (_nodes[left].right != NIL)
+            _nodes[_nodes[left].right].parent = cur;
+
+        _nodes[cur].parent = left;
+        _nodes[left].right = cur;
+
+        _nodes[left].parent = parent;
+        if (parent == NIL)
+            _root = left;
+        else
+        {
+            if (_nodes[parent].right == cur)
+                _nodes[parent].right = left;
+            else
+                _nodes[parent].left = left;
+        }
+    }
+
+private:
+    auto key_of(const Index idx) const -> const Key&
+    {
+        return _nodes[idx].entry.key;
+    }
+
+    static bool less(const Key& k1, const Key& k2)
+    {
+        return Compare{}(k1, k2);
+    }
+
+    static bool greater(const Key& k1, const Key& k2)
+    {
+        return Compare{}(k2, k1);
+    }
+
+public:
+    int black_depth() const
+    {
+        return black_depth_recurse(_root, 0);
+    }
+
+    bool validate() const
+    {
+        if (_nodes[_root].red || _nodes[NIL].red)
+            return false;
+        if (!validate_no_double_red(_root))
+            return false;
+        if (black_depth() < 0)
+            return false;
+
+        return true;
+    }
+
+private:
+    bool validate_no_double_red(const Index cur) const
+    {
+        if (cur == NIL)
+            return true;
+
+        const Node& node = _nodes[cur];
+        if (node.red && (_nodes[node.left].red || _nodes[node.right].red))
+            return false;
+
+        if (!validate_no_double_red(node.left))
+            return false;
+        if (!validate_no_double_red(node.right))
+            return false;
+
+        return true;
+    }
+
+    int black_depth_recurse(const Index cur, int black_depth) const
+    {
+        if (cur == NIL)
+            return black_depth;
+
+        black_depth += !_nodes[cur].red;
+
+        const int left_black_depth = black_depth_recurse(_nodes[cur].left, black_depth);
+        if (left_black_depth < 0)
+            return -1;
+
+        const int right_black_depth = black_depth_recurse(_nodes[cur].right, black_depth);
+        if (right_black_depth < 0)
+            return -1;
+
+        if (left_black_depth != right_black_depth)
+            return -1;
+
+        return left_black_depth;
+    }
+
+private:
+    std::size_t _size = 0;
+
+    Index _root = NIL;
+    /// head of the free list, chained through `Node::right`
+    Index _free = NIL;
+
+    /// `_nodes[NIL]` is the nil node, the rest are `N` usable nodes
+    Node _nodes[N + 1];
+};
+
+} // namespace bs
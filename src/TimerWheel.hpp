@@ -0,0 +1,380 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#include "AlterBinaryHeap.hpp"
+#include "FlatIdIndex.hpp"
+
+namespace bs
+{
+
+/// @brief Timer scheduler keyed by id, with O(1) `schedule()` and `cancel()` for the near deadlines.
+///
+/// A hierarchical timing wheel: `LEVELS` wheels of `SLOTS` slots, each slot of a level spanning a whole wheel of
+/// the level below. A timer goes to the level of the highest bit where its deadline differs from `now()`,
+/// in an intrusive list, and cascades down a level as the time reaches its slot, until it fires from level 0.
+/// A bitmap of the occupied slots per level lets `advance()` jump straight to the next slot to process.
+///
+/// Deadlines past the reach of the top wheel, `SLOTS^LEVELS` ticks, go to an `AlterBinaryHeap` instead,
+/// and move to the wheel once in reach.
+///
+/// Time is a tick count, starting at 0; the caller picks the tick duration.
+///
+/// @tparam UniqueId id of a timer
+/// @tparam UniqueIdHash hasher of `UniqueId`
+/// @tparam UniqueIdEqual equality check of `UniqueId`
+template <typename UniqueId, typename UniqueIdHash = std::hash<UniqueId>,
+          typename UniqueIdEqual = std::equal_to<UniqueId>>
+class TimerWheel
+{
+public:
+    using Tick = std::uint64_t;
+
+    static constexpr std::size_t SLOT_BITS = 6;
+    /// slots per level, one bit each in a `std::uint64_t` occupancy bitmap
+    static constexpr std::size_t SLOTS = std::size_t{1} << SLOT_BITS;
+    static constexpr std::size_t LEVELS = 4;
+
+private:
+    static constexpr Tick SLOT_MASK = SLOTS - 1;
+    /// ticks covered by the wheel, the rest are far
+    static constexpr std::size_t WHEEL_BITS = SLOT_BITS * LEVELS;
+
+    struct Timer
+    {
+        UniqueId id;
+        Tick deadline;
+        /// neighbours in the list of the slot
+        std::size_t prev;
+        std::size_t next;
+        /// `level * SLOTS + slot`
+        std::size_t bucket;
+        /// slot of the id in `_index`
+        std::size_t slot;
+    };
+
+    /// @brief Timer past the reach of the wheel, the earliest deadline on top of the heap.
+    struct FarTimer
+    {
+        UniqueId id;
+        Tick deadline;
+
+        auto unique_id() const -> UniqueId
+        {
+            return id;
+        }
+        bool operator<(const FarTimer& other) const
+        {
+            return deadline > other.deadline;
+        }
+    };
+
+public:
+    TimerWheel()
+    {
+        _heads.fill(NPOS);
+    }
+
+public: // Capacity
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    auto size() const -> std::size_t
+    {
+        return _timers.size() + _far.size();
+    }
+
+    /// @brief Time of the last `advance()`, up to which every timer fired.
+    auto now() const -> Tick
+    {
+        return _now;
+    }
+
+public: // Modifiers
+    /// @brief Sets the timer of `id` to fire at `deadline`, replacing its previous one if any.
+    /// A deadline not after `now()` fires at the next `advance()`.
+    void schedule(const UniqueId& id, Tick deadline)
+    {
+        deadline = std::max(deadline, _now + 1);
+        std::size_t pos = find_timer(id);
+
+        if (is_far(deadline))
+        {
+            if (pos != NPOS)
+                erase_timer(pos);
+            _far.push(FarTimer{.id = id, .deadline = deadline});
+            return;
+        }
+
+        if (pos == NPOS)
+        {
+            if (!_far.empty())
+                _far.erase(id);
+            pos = insert_timer(id);
+        }
+        else
+            unlink(pos);
+
+        _timers[pos].deadline = deadline;
+        link(pos);
+    }
+
+    /// @return whether `id` had a timer, which won't fire anymore
+    bool cancel(const UniqueId& id)
+    {
+        const std::size_t pos = find_timer(id);
+        if (pos == NPOS)
+            return !_far.empty() && _far.erase(id);
+
+        erase_timer(pos);
+        return true;
+    }
+
+    /// @brief Moves the time to `now`, and fires every timer due by then.
+    /// @param out receives the id of each fired timer, in deadline order (ties in no particular order)
+    /// @return `out` past the last fired id
+    template <std::weakly_incrementable OutputIt>
+    auto advance(Tick now, OutputIt out) -> OutputIt
+    {
+        for (Tick tick = next_tick(); tick <= now && tick != NEVER; tick = next_tick())
+            out = process(tick, out);
+
+        _now = std::max(_now, now);
+        return out;
+    }
+
+public: // Lookup
+    bool contains(const UniqueId& id) const
+    {
+        return find_timer(id) != NPOS || (!_far.empty() && _far.find(id) != _far.cend());
+    }
+
+private:
+    /// @brief Moves the far timers in reach, cascades the slots starting at `tick`, then fires level 0.
+    template <typename OutputIt>
+    auto process(Tick tick, OutputIt out) -> OutputIt
+    {
+        assert(tick > _now);
+        _now = tick;
+
+        while (!_far.empty() && !is_far(_far.top().deadline))
+        {
+            const std::size_t pos = insert_timer(_far.top().id);
+            _timers[pos].deadline = _far.top().deadline;
+            _far.pop();
+            link(pos);
+        }
+
+        // the deadlines of a cascaded slot are in `[tick, tick + span)`, so they all go to lower levels
+        for (std::size_t level = LEVELS; level-- > 1;)
+        {
+            const std::size_t shift = level * SLOT_BITS;
+            if ((tick & ((Tick{1} << shift) - 1)) != 0)
+                continue;
+
+            const std::size_t bucket = level * SLOTS + ((tick >> shift) & SLOT_MASK);
+            while (_heads[bucket] != NPOS)
+            {
+                const std::size_t pos = _heads[bucket];
+                unlink(pos);
+                link(pos);
+            }
+        }
+
+        const std::size_t bucket = tick & SLOT_MASK;
+        while (_heads[bucket] != NPOS)
+        {
+            const std::size_t pos = _heads[bucket];
+            assert(_timers[pos].deadline == tick);
+            *out = _timers[pos].id;
+            ++out;
+            erase_timer(pos);
+        }
+        return out;
+    }
+
+    /// @return the next tick with a slot to cascade or fire, or far timers to move in reach
+    auto next_tick() const -> Tick
+    {
+        Tick result = NEVER;
+
+        // the slots of a level are all after the current one, and before the next slot of the level above
+        for (std::size_t level = 0; level < LEVELS; ++level)
+        {
+            const std::size_t shift = level * SLOT_BITS;
+            const std::size_t current = (_now >> shift) & SLOT_MASK;
+            const std::uint64_t later =
+                (current == SLOT_MASK) ? 0 : _occupied[level] & (~std::uint64_t{0} << (current + 1));
+            if (later != 0)
+            {
+                const Tick wheel_start = (_now >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+                result = wheel_start | (static_cast<Tick>(std::countr_zero(later)) << shift);
+                break;
+            }
+        }
+
+        if (!_far.empty())
+            result = std::min(result, std::max(_now + 1, (_far.top().deadline >> WHEEL_BITS) << WHEEL_BITS));
+        return result;
+    }
+
+    /// @return whether `deadline` is past the reach of the wheel from `now()`
+    bool is_far(Tick deadline) const
+    {
+        return ((deadline ^ _now) >> WHEEL_BITS) != 0;
+    }
+
+    /// @brief Level of the highest bit where `deadline` differs from `now()`, and its slot there
+    auto bucket_of(Tick deadline) const -> std::size_t
+    {
+        assert(!is_far(deadline));
+
+        const Tick diff = deadline ^ _now;
+        const std::size_t level = (diff < SLOTS) ? 0 : (std::bit_width(diff) - 1) / SLOT_BITS;
+        return level * SLOTS + ((deadline >> (level * SLOT_BITS)) & SLOT_MASK);
+    }
+
+    /// @brief Pushes the timer at `pos` to the front of the list of the slot of its deadline.
+    void link(std::size_t pos)
+    {
+        Timer& timer = _timers[pos];
+        timer.bucket = bucket_of(timer.deadline);
+        timer.prev = NPOS;
+        timer.next = _heads[timer.bucket];
+        if (timer.next != NPOS)
+            _timers[timer.next].prev = pos;
+
+        _heads[timer.bucket] = pos;
+        _occupied[timer.bucket / SLOTS] |= std::uint64_t{1} << (timer.bucket % SLOTS);
+    }
+
+    void unlink(std::size_t pos)
+    {
+        const Timer& timer = _timers[pos];
+        if (timer.prev != NPOS)
+            _timers[timer.prev].next = timer.next;
+        else
+            _heads[timer.bucket] = timer.next;
+        if (timer.next != NPOS)
+            _timers[timer.next].prev = timer.prev;
+
+        if (_heads[timer.bucket] == NPOS)
+            _occupied[timer.bucket / SLOTS] &= ~(std::uint64_t{1} << (timer.bucket % SLOTS));
+    }
+
+    /// @return position of a new unlinked timer of `id`, which should not have one
+    auto insert_timer(const UniqueId& id) -> std::size_t
+    {
+        const std::size_t pos = _timers.size();
+        _timers.push_back(Timer{.id = id, .deadline = 0, .prev = NPOS, .next = NPOS, .bucket = 0, .slot = NPOS});
+        _timers[pos].slot = _index.insert(id, pos, on_timer_move());
+        return pos;
+    }
+
+    /// @brief Erases the timer at `pos`, moving the last one into its place.
+    void erase_timer(std::size_t pos)
+    {
+        unlink(pos);
+        _index.erase(_timers[pos].slot, on_timer_move());
+
+        const std::size_t last = _timers.size() - 1;
+        if (pos != last)
+        {
+            Timer& moved = _timers[pos];
+            moved = _timers[last];
+            if (moved.prev != NPOS)
+                _timers[moved.prev].next = pos;
+            else
+                _heads[moved.bucket] = pos;
+            if (moved.next != NPOS)
+                _timers[moved.next].prev = pos;
+            _index.position(moved.slot) = pos;
+        }
+        _timers.pop_back();
+    }
+
+    auto find_timer(const UniqueId& id) const -> std::size_t
+    {
+        const std::size_t slot = _index.find(id, timer_id_of());
+        return (slot == NPOS) ? NPOS : _index.position(slot);
+    }
+
+private:
+    /// @brief Reads the id of a timer, for `FlatIdIndex`
+    auto timer_id_of() const
+    {
+        return [this](std::size_t pos) -> const UniqueId& { return _timers[pos].id; };
+    }
+
+    /// @brief Follows the slot moves of `FlatIdIndex`
+    auto on_timer_move()
+    {
+        return [this](std::size_t pos, std::size_t slot) { _timers[pos].slot = slot; };
+    }
+
+public:
+    bool validate() const
+    {
+        if (_index.size() != _timers.size() || !_far.validate())
+            return false;
+
+        std::size_t linked = 0;
+        for (std::size_t bucket = 0; bucket < LEVELS * SLOTS; ++bucket)
+        {
+            const bool occupied = (_occupied[bucket / SLOTS] >> (bucket % SLOTS)) & 1;
+            if (occupied != (_heads[bucket] != NPOS))
+                return false;
+
+            for (std::size_t pos = _heads[bucket], prev = NPOS; pos != NPOS; prev = pos, pos = _timers[pos].next)
+            {
+                if (++linked > _timers.size())
+                    return false;
+
+                // still in the slot it would be linked to now, which is after the current one of its level
+                const Timer& timer = _timers[pos];
+                if (timer.prev != prev || timer.bucket != bucket || timer.deadline <= _now)
+                    return false;
+                if (is_far(timer.deadline) || bucket_of(timer.deadline) != bucket)
+                    return false;
+                if (_index.position(timer.slot) != pos)
+                    return false;
+            }
+        }
+        if (linked != _timers.size())
+            return false;
+
+        return std::all_of(_far.begin(), _far.end(), [this](const FarTimer& timer) {
+            return is_far(timer.deadline) && find_timer(timer.id) == NPOS;
+        });
+    }
+
+private:
+    static constexpr std::size_t NPOS = FlatIdIndex<UniqueId, UniqueIdHash, UniqueIdEqual>::NPOS;
+    static constexpr Tick NEVER = UINT64_MAX;
+
+private:
+    Tick _now = 0;
+
+    /// timers in reach of the wheel, found through `_index`
+    std::vector<Timer> _timers;
+    FlatIdIndex<UniqueId, UniqueIdHash, UniqueIdEqual> _index;
+
+    /// first timer of each slot, `level * SLOTS + slot`
+    std::array<std::size_t, LEVELS * SLOTS> _heads;
+    /// bit `slot` of `_occupied[level]` is set if the slot has timers
+    std::array<std::uint64_t, LEVELS> _occupied{};
+
+    AlterBinaryHeap<FarTimer, std::less<FarTimer>, UniqueIdHash, UniqueIdEqual> _far;
+};
+
+} // namespace bs
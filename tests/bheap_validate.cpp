@@ -1,11 +1,20 @@
-#include "AlterBinaryHeap.hpp"
+#include "AlterHeap.hpp"
+#include "AlterSpillHeap.hpp"
+#include "AlterTopKHeap.hpp"
 
 #include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <filesystem>
 #include <format>
+#include <functional>
 #include <future>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <optional>
 #include <random>
+#include <ranges>
 #include <sstream>
 #include <stdexcept>
 #include <thread>
@@ -35,6 +44,21 @@ void append_args(std::ostream& os, const Args&... args)
 
 static constexpr int NUM_OF_COMMANDS_PER_TEST = 1'000'000;
 
+// commands of the other engines and of the other workers, fewer so that all the workers take seconds together
+static constexpr int NUM_OF_COMMANDS_PER_VARIANT = NUM_OF_COMMANDS_PER_TEST / 10;
+
+// values pushed at most by a single `push_many()`
+static constexpr int MAX_PUSH_MANY_COUNT = 64;
+
+// values kept by `topk_worker()`
+static constexpr std::size_t TOP_K = 64;
+
+// largest hot capacity of `spill_worker()`, small so that it spills and compacts often
+static constexpr std::size_t MAX_SPILL_HOT_CAPACITY = 16;
+
+// bound of the ids of the dense heaps, small as each new heap zero-fills its index up to the largest id
+static constexpr std::size_t DENSE_ID_CAPACITY = 4096;
+
 struct MyData
 {
     int priority;
@@ -50,11 +74,30 @@ struct MyData
     }
 };
 
+struct MyDataPriority
+{
+    auto operator()(const MyData& data) const -> unsigned
+    {
+        return (unsigned)data.priority;
+    }
+};
+
 enum class Command
 {
     PUSH,
     UPDATE,
     POP,
+    REBUILD,
+    ERASE,
+    MODIFY,
+    INCREASE_KEY,
+    DECREASE_KEY,
+    PUSH_MANY,
+    POP_K,
+    POP_MIN,
+    MELD,
+    SORTED_VIEW,
+    BULK_UPDATE,
 
     TOTAL_COUNT
 };
@@ -94,6 +137,39 @@ std::ostream& operator<<(std::ostream& os, const ReproduceInfo& repro)
         case Command::POP:
             os << "pop(key=" << cmd.key << ", id=" << cmd.id << ")\n";
             break;
+        case Command::REBUILD:
+            os << "rebuild(overwrites=" << cmd.key << ")\n";
+            break;
+        case Command::ERASE:
+            os << "erase(id=" << cmd.id << ")\n";
+            break;
+        case Command::MODIFY:
+            os << "modify(key=" << cmd.key << ", id=" << cmd.id << ")\n";
+            break;
+        case Command::INCREASE_KEY:
+            os << "increase_key(key=" << cmd.key << ", id=" << cmd.id << ")\n";
+            break;
+        case Command::DECREASE_KEY:
+            os << "decrease_key(key=" << cmd.key << ", id=" << cmd.id << ")\n";
+            break;
+        case Command::PUSH_MANY:
+            os << "push_many(count=" << cmd.key << ")\n";
+            break;
+        case Command::POP_K:
+            os << "pop_k(k=" << cmd.key << ")\n";
+            break;
+        case Command::POP_MIN:
+            os << "pop_min()\n";
+            break;
+        case Command::MELD:
+            os << "meld(count=" << cmd.key << ")\n";
+            break;
+        case Command::SORTED_VIEW:
+            os << "sorted_view(k=" << cmd.key << ")\n";
+            break;
+        case Command::BULK_UPDATE:
+            os << "bulk_update(count=" << cmd.key << ")\n";
+            break;
 
         default:
             throw std::logic_error(std::format("Invalid command kind={}", (int)cmd.cmd));
@@ -103,8 +179,103 @@ std::ostream& operator<<(std::ostream& os, const ReproduceInfo& repro)
     return os;
 }
 
-bool worker(unsigned seed);
-bool validate(unsigned seed, int idx, const bs::AlterBinaryHeap<MyData>&, const ReproduceInfo&);
+/// @brief Heaps which take in the values of another one at once
+template <typename Heap>
+concept Meldable = requires(Heap& h, Heap&& other) { h.meld(std::move(other)); };
+
+/// @brief Heaps which iterate their values in priority order
+template <typename Heap>
+concept SortedViewable = requires(const Heap& h) { h.sorted_view(); };
+
+/// @brief Heaps which defer the sifts of a batch of updates
+template <typename Heap>
+concept BulkUpdatable = requires(Heap& h) {
+    h.begin_bulk_update();
+    h.end_bulk_update();
+};
+
+/// @brief Heaps which also pop their worst value
+template <typename Heap>
+concept DoubleEnded = requires(Heap& h) {
+    h.top_min();
+    h.pop_min();
+};
+
+/// @brief Bound of the ids of a heap, 0 if it takes any
+template <typename Heap>
+constexpr std::size_t ID_CAPACITY = 0;
+
+template <typename T, typename Compare, typename Hash, typename Equal, std::size_t Arity, std::size_t IdCapacity>
+constexpr std::size_t ID_CAPACITY<bs::AlterBinaryHeap<T, Compare, Hash, Equal, Arity, IdCapacity>> = IdCapacity;
+
+/// @brief Node layout of each heap, to check its memory accounting exactly,
+/// along with the least bytes its id index & tables take per value
+template <typename Heap>
+struct NodeLayout;
+
+template <typename T, typename Compare, typename Hash, typename Equal, std::size_t Arity, std::size_t IdCapacity>
+struct NodeLayout<bs::AlterBinaryHeap<T, Compare, Hash, Equal, Arity, IdCapacity>>
+{
+    static constexpr std::size_t MEMBER_BYTES = sizeof(T) + sizeof(std::size_t);
+    // a position per dense id, or a position & hash per flat slot, then a position, slot & generation per handle
+    static constexpr std::size_t MIN_BUCKET_BYTES =
+        (IdCapacity ? 1 : 2) * sizeof(std::size_t) + 3 * sizeof(std::size_t);
+
+    T value;
+    std::size_t handle;
+};
+
+template <typename T, typename Compare, typename Hash, typename Equal>
+struct NodeLayout<bs::AlterMinMaxHeap<T, Compare, Hash, Equal>>
+{
+    static constexpr std::size_t MEMBER_BYTES = sizeof(T) + sizeof(std::size_t);
+    static constexpr std::size_t MIN_BUCKET_BYTES = 2 * sizeof(std::size_t);
+
+    T value;
+    std::size_t slot;
+};
+
+template <typename T, typename Compare, typename Hash, typename Equal>
+struct NodeLayout<bs::AlterPairingHeap<T, Compare, Hash, Equal>>
+{
+    static constexpr std::size_t MEMBER_BYTES = sizeof(T) + 4 * sizeof(std::size_t);
+    static constexpr std::size_t MIN_BUCKET_BYTES = 2 * sizeof(std::size_t);
+
+    T value;
+    std::size_t slot;
+    std::size_t child;
+    std::size_t sibling;
+    std::size_t prev;
+};
+
+template <typename T, typename PriorityOf, typename Hash, typename Equal>
+struct NodeLayout<bs::AlterRadixHeap<T, PriorityOf, Hash, Equal>>
+{
+    static constexpr std::size_t MEMBER_BYTES = sizeof(T) + 2 * sizeof(std::size_t) + sizeof(std::uint8_t);
+    // a flat slot, and a position in its radix bucket
+    static constexpr std::size_t MIN_BUCKET_BYTES = 3 * sizeof(std::size_t);
+
+    T value;
+    std::size_t slot;
+    std::size_t bucket_pos;
+    std::uint8_t bucket;
+};
+
+/// @brief Commands run by `worker()` on a heap, all of them on the binary heap only
+template <typename Heap>
+constexpr int NUM_OF_COMMANDS = NUM_OF_COMMANDS_PER_VARIANT;
+
+template <>
+constexpr int NUM_OF_COMMANDS<bs::AlterBinaryHeap<MyData>> = NUM_OF_COMMANDS_PER_TEST;
+
+template <typename Heap>
+bool worker(unsigned seed, const char* engine);
+template <typename Heap>
+bool handle_worker(unsigned seed, const char* engine);
+bool topk_worker(unsigned seed);
+bool spill_worker(unsigned seed);
+template <typename Heap>
+bool validate(unsigned seed, int idx, const Heap&, const ReproduceInfo&);
 
 int main()
 {
@@ -120,16 +291,35 @@ int main()
     std::vector<std::future<bool>> futures;
     std::vector<bool> results;
 
-    futures.reserve(cores);
-    results.reserve(cores);
+    futures.reserve(cores * 11);
+    results.reserve(cores * 11);
 
     std::random_device rd;
+    using RadixEngine = bs::RadixHeapEngine<MyDataPriority>;
 
     for (unsigned i = 0; i < cores; ++i)
-        futures.push_back(std::async(std::launch::async, worker, rd()));
+    {
+        futures.push_back(std::async(std::launch::async, worker<bs::AlterBinaryHeap<MyData>>, rd(), "binary"));
+        futures.push_back(std::async(std::launch::async, worker<bs::AlterDaryHeap<MyData, 4>>, rd(), "4-ary"));
+        futures.push_back(std::async(std::launch::async, worker<bs::AlterDaryHeap<MyData, 8>>, rd(), "8-ary"));
+        futures.push_back(
+            std::async(std::launch::async, worker<bs::AlterDenseIdHeap<MyData, DENSE_ID_CAPACITY>>, rd(), "dense"));
+        futures.push_back(
+            std::async(std::launch::async, worker<bs::AlterHeap<MyData, bs::PairingHeapEngine>>, rd(), "pairing"));
+        futures.push_back(std::async(std::launch::async, worker<bs::AlterHeap<MyData, RadixEngine>>, rd(), "radix"));
+        futures.push_back(
+            std::async(std::launch::async, worker<bs::AlterHeap<MyData, bs::MinMaxHeapEngine>>, rd(), "min-max"));
+        futures.push_back(
+            std::async(std::launch::async, handle_worker<bs::AlterBinaryHeap<MyData>>, rd(), "binary handles"));
+        futures.push_back(std::async(std::launch::async,
+                                     handle_worker<bs::AlterDenseIdHeap<MyData, DENSE_ID_CAPACITY>>, rd(),
+                                     "dense handles"));
+        futures.push_back(std::async(std::launch::async, topk_worker, rd()));
+        futures.push_back(std::async(std::launch::async, spill_worker, rd()));
+    }
 
-    for (unsigned i = 0; i < cores; ++i)
-        results.push_back(futures[i].get());
+    for (auto& future : futures)
+        results.push_back(future.get());
 
     if (!std::ranges::all_of(results, [](const bool val) { return val; }))
         return -1;
@@ -138,38 +328,53 @@ int main()
     return 0;
 }
 
-bool worker(unsigned seed)
+template <typename Heap>
+bool worker(unsigned seed, const char* engine)
 {
     // print current thread & seed info
     {
         std::ostringstream worker_info;
-        worker_info << "TID #" << std::this_thread::get_id() << ": seed=" << seed << "\n";
+        worker_info << "TID #" << std::this_thread::get_id() << ": seed=" << seed << ", engine=" << engine << "\n";
         std::cout << worker_info.str();
     }
 
     int idx = -1;
 
-    bs::AlterBinaryHeap<MyData> h;
+    Heap h;
 
     ReproduceInfo repro;
 
     TEST_ASSERT(h.empty());
     if (!validate(seed, idx, h, repro))
         return false;
+    // nothing allocated yet, so only the heap object itself
+    TEST_ASSERT(h.memory_usage().overhead_bytes == sizeof(h) && h.memory_usage().total_bytes() == sizeof(h));
 
     std::mt19937 rand(seed);
     std::uniform_int_distribution all_int_range;
     std::uniform_int_distribution command_range(0, (int)Command::TOTAL_COUNT - 1);
 
-    for (idx = 0; idx < NUM_OF_COMMANDS_PER_TEST; ++idx)
+    // the dense heaps wrap the ids around their capacity, then the new ones overwrite old ones
+    int next_id = 0;
+    const auto new_id = [&next_id] {
+        const int id = next_id++;
+        return ID_CAPACITY<Heap> > 0 ? id % (int)ID_CAPACITY<Heap> : id;
+    };
+
+    // monotone heaps take priorities up to the last popped one
+    int bound = std::numeric_limits<int>::max();
+    const auto priority_range = [&bound] { return std::uniform_int_distribution(0, bound); };
+
+    for (idx = 0; idx < NUM_OF_COMMANDS<Heap>; ++idx)
     {
         const auto command_kind = h.empty() ? Command::PUSH : (Command)command_range(rand);
         switch (command_kind)
         {
         case Command::PUSH: {
-            const int num = all_int_range(rand);
-            repro.commands.emplace_back(Command::PUSH, num, -idx);
-            h.push(MyData(num, idx));
+            const int num = priority_range()(rand);
+            const int id = new_id();
+            repro.commands.emplace_back(Command::PUSH, num, id);
+            h.push(MyData(num, id));
             break;
         }
         case Command::UPDATE: {
@@ -179,17 +384,223 @@ bool worker(unsigned seed)
             const std::size_t selected_idx = select_range(rand);
             const int selected_id = h.begin()[selected_idx].id;
 
-            const int num = all_int_range(rand);
+            const int num = priority_range()(rand);
             repro.commands.emplace_back(Command::UPDATE, num, selected_id);
             h.push(MyData(num, selected_id));
             TEST_ASSERT(prev_size == h.size());
+            TEST_ASSERT(h.find(selected_id) != h.cend() && h.find(selected_id)->priority == num, repro);
             break;
         }
-        case Command::POP: {
-            repro.commands.emplace_back(Command::POP);
+        case Command::POP:
+        case Command::POP_MIN: {
+            repro.commands.emplace_back(command_kind);
+            // the single-ended heaps pop their top instead
+            if constexpr (DoubleEnded<Heap>)
+            {
+                if (command_kind == Command::POP_MIN)
+                {
+                    const int id = h.top_min().id;
+                    h.pop_min();
+                    TEST_ASSERT(h.find(id) == h.cend(), repro);
+                    break;
+                }
+            }
+            if constexpr (Heap::MONOTONE)
+                bound = h.top().priority;
             h.pop();
             break;
         }
+        case Command::REBUILD: {
+            // current values, then overwrites of random ids, which should win
+            std::vector<MyData> values(h.begin(), h.end());
+            std::uniform_int_distribution<std::size_t> select_range(0, values.size() - 1);
+            const int overwrites = (int)select_range(rand);
+            for (int i = 0; i < overwrites; ++i)
+                values.push_back(MyData(all_int_range(rand), values[select_range(rand)].id));
+            std::shuffle(values.begin(), values.begin() + (std::ptrdiff_t)h.size(), rand);
+
+            repro.commands.emplace_back(Command::REBUILD, overwrites);
+            const std::size_t prev_size = h.size();
+            h = Heap(values.begin(), values.end());
+            bound = std::numeric_limits<int>::max();
+            TEST_ASSERT(prev_size == h.size(), repro);
+            for (std::size_t i = prev_size; i < values.size(); ++i)
+            {
+                const auto last = std::find_if(values.rbegin(), values.rend(),
+                                               [&](const MyData& val) { return val.id == values[i].id; });
+                TEST_ASSERT(h.find(values[i].id)->priority == last->priority, repro);
+            }
+            break;
+        }
+        case Command::ERASE: {
+            const std::size_t prev_size = h.size();
+            std::uniform_int_distribution<std::size_t> select_range(0, h.size() - 1);
+            const int selected_id = h.begin()[select_range(rand)].id;
+
+            repro.commands.emplace_back(Command::ERASE, 0, selected_id);
+            TEST_ASSERT(h.erase(selected_id), repro);
+            TEST_ASSERT(!h.erase(selected_id), repro);
+            TEST_ASSERT(prev_size == h.size() + 1, repro);
+            TEST_ASSERT(h.find(selected_id) == h.cend(), repro);
+            break;
+        }
+        case Command::MODIFY:
+        case Command::INCREASE_KEY:
+        case Command::DECREASE_KEY: {
+            std::uniform_int_distribution<std::size_t> select_range(0, h.size() - 1);
+            const MyData selected = h.begin()[select_range(rand)];
+
+            int num = priority_range()(rand);
+            if (command_kind == Command::INCREASE_KEY)
+                num = std::max(num, selected.priority);
+            else if (command_kind == Command::DECREASE_KEY)
+                num = std::min(num, selected.priority);
+
+            repro.commands.emplace_back(command_kind, num, selected.id);
+            const auto fn = [num](MyData& data) { data.priority = num; };
+            const bool found = (command_kind == Command::MODIFY)         ? h.modify(selected.id, fn)
+                               : (command_kind == Command::INCREASE_KEY) ? h.increase_key(selected.id, fn)
+                                                                         : h.decrease_key(selected.id, fn);
+            TEST_ASSERT(found, repro);
+            TEST_ASSERT(h.find(selected.id)->priority == num, repro);
+            TEST_ASSERT(!h.modify(-1, fn), repro);
+            break;
+        }
+        case Command::PUSH_MANY:
+        case Command::MELD: {
+            std::uniform_int_distribution count_range(1, MAX_PUSH_MANY_COUNT);
+            std::uniform_int_distribution<std::size_t> select_range(0, h.size() - 1);
+            const int count = count_range(rand);
+
+            std::vector<MyData> values;
+            for (int i = 0; i < count; ++i)
+            {
+                const bool overwrite = !h.empty() && rand() % 2;
+                const int id = overwrite ? h.begin()[select_range(rand)].id : new_id();
+                values.push_back(MyData(priority_range()(rand), id));
+            }
+
+            repro.commands.emplace_back(command_kind, count);
+            std::vector<MyData> expected(h.begin(), h.end());
+            expected.insert(expected.end(), values.begin(), values.end());
+            // the heaps which can't meld push the same values instead
+            if constexpr (Meldable<Heap>)
+            {
+                if (command_kind == Command::MELD)
+                {
+                    Heap other;
+                    for (const MyData& value : values)
+                        other.push(value);
+                    h.meld(std::move(other));
+                    TEST_ASSERT(other.empty() && other.validate(), repro);
+                }
+                else
+                    h.push_many(values);
+            }
+            else
+                h.push_many(values);
+            for (const MyData& value : values)
+            {
+                const auto last = std::find_if(values.rbegin(), values.rend(),
+                                               [&](const MyData& val) { return val.id == value.id; });
+                TEST_ASSERT(h.find(value.id) != h.cend() && h.find(value.id)->priority == last->priority, repro);
+            }
+            std::ranges::sort(expected, {}, &MyData::id);
+            const auto duplicates = std::ranges::unique(expected, {}, &MyData::id);
+            expected.erase(duplicates.begin(), duplicates.end());
+            TEST_ASSERT(h.size() == expected.size(), repro);
+            break;
+        }
+        case Command::SORTED_VIEW: {
+            // past `size()` on purpose, which should stop at the end
+            std::uniform_int_distribution<std::size_t> k_range(0, h.size() + 1);
+            const std::size_t k = k_range(rand);
+            repro.commands.emplace_back(Command::SORTED_VIEW, (int)k);
+
+            if constexpr (SortedViewable<Heap>)
+            {
+                std::vector<int> expected;
+                for (const MyData& value : h)
+                    expected.push_back(value.priority);
+                std::ranges::sort(expected, std::greater<>{});
+                expected.resize(std::min(k, h.size()));
+
+                std::vector<int> sorted;
+                for (const MyData& value : h.sorted_view() | std::views::take(k))
+                    sorted.push_back(value.priority);
+                TEST_ASSERT(sorted == expected, repro);
+            }
+            break;
+        }
+        case Command::BULK_UPDATE: {
+            // either a few updates, sifted one by one at the end, or up to the whole heap, rebuilt at once
+            std::uniform_int_distribution<std::size_t> select_range(0, h.size() - 1);
+            std::uniform_int_distribution<std::size_t> count_range(0, (rand() % 2) ? 4 : h.size());
+            const std::size_t count = count_range(rand);
+            repro.commands.emplace_back(Command::BULK_UPDATE, (int)count);
+
+            std::vector<MyData> expected(h.begin(), h.end());
+            if constexpr (BulkUpdatable<Heap>)
+                h.begin_bulk_update();
+            // the heaps without bulk updates sift each of them right away instead
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                const int num = priority_range()(rand);
+                const int id = (rand() % 8 == 0) ? new_id() : h.begin()[select_range(rand)].id;
+                const auto fn = [num](MyData& data) { data.priority = num; };
+                switch (rand() % 3)
+                {
+                case 0:
+                    h.push(MyData(num, id));
+                    break;
+                case 1:
+                    if (!h.modify(id, fn))
+                        h.push(MyData(num, id));
+                    break;
+                default:
+                    h.push_many(std::vector{MyData(num, id)});
+                    break;
+                }
+                expected.push_back(MyData(num, id));
+            }
+            if constexpr (BulkUpdatable<Heap>)
+                h.end_bulk_update();
+
+            std::ranges::stable_sort(expected, {}, &MyData::id);
+            const auto duplicates = std::ranges::unique(expected.rbegin(), expected.rend(), {}, &MyData::id);
+            expected.erase(expected.begin(), duplicates.begin().base());
+            TEST_ASSERT(h.size() == expected.size(), repro);
+            for (const MyData& value : expected)
+                TEST_ASSERT(h.find(value.id) != h.cend() && h.find(value.id)->priority == value.priority, repro);
+            break;
+        }
+        case Command::POP_K: {
+            // past `size()` on purpose, which should pop everything
+            std::uniform_int_distribution<std::size_t> k_range(0, h.size() + 1);
+            const std::size_t k = k_range(rand);
+            const std::size_t prev_size = h.size();
+
+            std::vector<int> expected;
+            for (const MyData& value : h)
+                expected.push_back(value.priority);
+            std::ranges::sort(expected, std::greater<>{});
+            expected.resize(std::min(k, prev_size));
+
+            repro.commands.emplace_back(Command::POP_K, (int)k);
+            std::vector<MyData> popped;
+            h.pop_k(k, std::back_inserter(popped));
+            TEST_ASSERT(popped.size() == expected.size(), repro);
+            TEST_ASSERT(h.size() == prev_size - popped.size(), repro);
+            for (std::size_t i = 0; i < popped.size(); ++i)
+            {
+                TEST_ASSERT(popped[i].priority == expected[i], repro);
+                TEST_ASSERT(h.find(popped[i].id) == h.cend(), repro);
+            }
+            if constexpr (Heap::MONOTONE)
+                if (!popped.empty())
+                    bound = popped.back().priority;
+            break;
+        }
 
         default:
             throw std::logic_error(std::format("Invalid command kind={}", (int)command_kind));
@@ -201,8 +612,377 @@ bool worker(unsigned seed)
     return true;
 }
 
-bool validate(unsigned seed, int idx, const bs::AlterBinaryHeap<MyData>& h, const ReproduceInfo& repro)
+template <typename Heap>
+bool handle_worker(unsigned seed, const char* engine)
+{
+    // print current thread & seed info
+    {
+        std::ostringstream worker_info;
+        worker_info << "TID #" << std::this_thread::get_id() << ": seed=" << seed << ", engine=" << engine << "\n";
+        std::cout << worker_info.str();
+    }
+
+    enum class HandleCommand
+    {
+        PUSH,
+        PUSH_AGAIN,
+        UPDATE,
+        ERASE,
+        POP,
+        MELD,
+        PUSH_OUT_OF_RANGE,
+
+        TOTAL_COUNT
+    };
+
+    int idx = -1;
+
+    Heap h;
+    ReproduceInfo repro;
+    TEST_ASSERT(h.memory_usage().overhead_bytes == sizeof(h) && h.memory_usage().total_bytes() == sizeof(h));
+
+    // handles of the pushed ids, the stale ones included
+    std::vector<typename Heap::Handle> handles;
+    std::vector<int> live_ids;
+    // ids of the erased values, given again to the new ones, so that the ids stay below the peak size
+    std::vector<int> free_ids;
+    const auto new_id = [&handles, &free_ids] {
+        if (free_ids.empty())
+            return (int)handles.size();
+        const int id = free_ids.back();
+        free_ids.pop_back();
+        return id;
+    };
+    const auto keep_handle = [&handles](int id, typename Heap::Handle handle) {
+        if ((std::size_t)id == handles.size())
+            handles.push_back(handle);
+        else
+            handles[id] = handle;
+    };
+
+    std::mt19937 rand(seed);
+    std::uniform_int_distribution all_int_range;
+    std::uniform_int_distribution command_range(0, (int)HandleCommand::TOTAL_COUNT - 1);
+
+    for (idx = 0; idx < NUM_OF_COMMANDS_PER_VARIANT; ++idx)
+    {
+        const auto command_kind = h.empty() ? HandleCommand::PUSH : (HandleCommand)command_range(rand);
+        std::uniform_int_distribution<std::size_t> live_range(0, live_ids.empty() ? 0 : live_ids.size() - 1);
+
+        switch (command_kind)
+        {
+        case HandleCommand::PUSH: {
+            const int id = new_id();
+            const int num = all_int_range(rand);
+            repro.commands.emplace_back(Command::PUSH, num, id);
+            keep_handle(id, h.push(MyData(num, id)));
+            live_ids.push_back(id);
+            TEST_ASSERT(h.contains(handles[id]) && h.get(handles[id]).id == id, repro);
+            break;
+        }
+        case HandleCommand::PUSH_AGAIN: {
+            const int id = live_ids[live_range(rand)];
+            const int num = all_int_range(rand);
+            repro.commands.emplace_back(Command::PUSH, num, id);
+            TEST_ASSERT(h.push(MyData(num, id)) == handles[id], "push(id=", id, ") changed the handle\n", repro);
+            TEST_ASSERT(h.get(handles[id]).priority == num, repro);
+            break;
+        }
+        case HandleCommand::UPDATE: {
+            const int id = live_ids[live_range(rand)];
+            const int num = all_int_range(rand);
+            repro.commands.emplace_back(Command::UPDATE, num, id);
+            TEST_ASSERT(h.update(handles[id], MyData(num, id)), repro);
+            TEST_ASSERT(h.get(handles[id]).priority == num && h.find(id)->priority == num, repro);
+            break;
+        }
+        case HandleCommand::ERASE:
+        case HandleCommand::POP: {
+            int id = -1;
+            if (command_kind == HandleCommand::ERASE)
+            {
+                const std::size_t selected = live_range(rand);
+                id = live_ids[selected];
+                repro.commands.emplace_back(Command::ERASE, 0, id);
+                TEST_ASSERT(h.erase(handles[id]), repro);
+                TEST_ASSERT(!h.erase(handles[id]), "erased twice\n", repro);
+            }
+            else
+            {
+                id = h.top().id;
+                repro.commands.emplace_back(Command::POP, h.top().priority, id);
+                h.pop();
+            }
+            std::erase(live_ids, id);
+            free_ids.push_back(id);
+
+            TEST_ASSERT(!h.contains(handles[id]) && h.find(id) == h.cend(), repro);
+            TEST_ASSERT(!h.update(handles[id], MyData(0, id)), repro);
+            break;
+        }
+        case HandleCommand::MELD: {
+            // a new id, and an overwrite which keeps its handle
+            const int added_id = new_id();
+            const MyData overwrite(all_int_range(rand), live_ids[live_range(rand)]);
+            Heap other;
+            other.push(MyData(all_int_range(rand), added_id));
+            other.push(overwrite);
+
+            repro.commands.emplace_back(Command::MELD, 2);
+            h.meld(std::move(other));
+            TEST_ASSERT(other.empty(), repro);
+            TEST_ASSERT(h.get(handles[overwrite.id]).priority == overwrite.priority, repro);
+
+            const MyData added = *h.find(added_id);
+            keep_handle(added_id, h.push(added));
+            live_ids.push_back(added_id);
+            break;
+        }
+        case HandleCommand::PUSH_OUT_OF_RANGE: {
+            // a dense heap refuses the ids past its capacity, and is left as it was
+            if constexpr (ID_CAPACITY<Heap> > 0)
+            {
+                const int id = (int)ID_CAPACITY<Heap> + (int)(rand() % 16);
+                const int num = all_int_range(rand);
+                repro.commands.emplace_back(Command::PUSH, num, id);
+
+                bool refused = false;
+                try
+                {
+                    h.push(MyData(num, id));
+                }
+                catch (const std::out_of_range&)
+                {
+                    refused = true;
+                }
+                TEST_ASSERT(refused && h.find(id) == h.cend(), repro);
+            }
+            break;
+        }
+
+        default:
+            throw std::logic_error(std::format("Invalid command kind={}", (int)command_kind));
+        }
+
+        TEST_ASSERT(h.size() == live_ids.size(), repro);
+        for (const int id : live_ids)
+            TEST_ASSERT(h.contains(handles[id]) && h.get(handles[id]).id == id, "id=", id, "\n", repro);
+        if (!validate(seed, idx, h, repro))
+            return false;
+    }
+
+    return true;
+}
+
+bool topk_worker(unsigned seed)
+{
+    // print current thread & seed info
+    {
+        std::ostringstream worker_info;
+        worker_info << "TID #" << std::this_thread::get_id() << ": seed=" << seed << ", engine=top-k\n";
+        std::cout << worker_info.str();
+    }
+
+    int idx = -1;
+
+    bs::AlterTopKHeap<MyData> h(TOP_K);
+    // the values which should be kept, in no particular order
+    std::vector<MyData> kept;
+
+    std::mt19937 rand(seed);
+    // few enough ids that they're often pushed again, and priorities which often tie
+    std::uniform_int_distribution id_range(0, (int)TOP_K * 4);
+    std::uniform_int_distribution priority_range(0, (int)TOP_K * 16);
+    std::uniform_int_distribution command_range(0, 9);
+
+    for (idx = 0; idx < NUM_OF_COMMANDS_PER_VARIANT; ++idx)
+    {
+        const int command = command_range(rand);
+        if (command == 0 && !h.empty())
+        {
+            const MyData top = h.top();
+            TEST_ASSERT(top.priority == std::ranges::max_element(kept, {}, &MyData::priority)->priority);
+            h.pop();
+            std::erase_if(kept, [&top](const MyData& value) { return value.id == top.id; });
+        }
+        else if (command == 1 && !h.empty())
+        {
+            const int id = kept[std::uniform_int_distribution<std::size_t>(0, kept.size() - 1)(rand)].id;
+            TEST_ASSERT(h.erase(id));
+            std::erase_if(kept, [id](const MyData& value) { return value.id == id; });
+        }
+        else
+        {
+            const MyData value(priority_range(rand), id_range(rand));
+            const auto evicted = h.push(value);
+
+            const auto same_id = std::ranges::find(kept, value.id, &MyData::id);
+            if (same_id != kept.end())
+            {
+                TEST_ASSERT(!evicted, "overwrite of id=", value.id, " evicted a value");
+                *same_id = value;
+            }
+            else if (kept.size() < TOP_K)
+            {
+                TEST_ASSERT(!evicted);
+                kept.push_back(value);
+            }
+            else
+            {
+                const auto worst = std::ranges::min_element(kept, {}, &MyData::priority);
+                TEST_ASSERT(evicted.has_value());
+                if (worst->priority < value.priority)
+                {
+                    TEST_ASSERT(evicted->priority == worst->priority && evicted->id != value.id);
+                    TEST_ASSERT(h.find(evicted->id) == h.cend());
+                    *std::ranges::find(kept, evicted->id, &MyData::id) = value;
+                }
+                else
+                    TEST_ASSERT(evicted->id == value.id && h.find(value.id) == h.cend(), "should be rejected");
+            }
+        }
+
+        TEST_ASSERT(h.validate());
+        TEST_ASSERT(h.size() == kept.size() && h.size() <= TOP_K);
+        for (const MyData& value : kept)
+            TEST_ASSERT(h.find(value.id) != h.cend() && h.find(value.id)->priority == value.priority, "id=", value.id);
+        TEST_ASSERT(h.peak_memory_usage().node_count <= TOP_K);
+    }
+
+    return true;
+}
+
+bool spill_worker(unsigned seed)
+{
+    // print current thread & seed info
+    {
+        std::ostringstream worker_info;
+        worker_info << "TID #" << std::this_thread::get_id() << ": seed=" << seed << ", engine=spill\n";
+        std::cout << worker_info.str();
+    }
+
+    int idx = -1;
+
+    std::mt19937 rand(seed);
+    const std::size_t hot_capacity = std::uniform_int_distribution<std::size_t>(1, MAX_SPILL_HOT_CAPACITY)(rand);
+
+    // a directory of its own, which goes away for a while to make the spills fail
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() / ("bheap-validate-spill-" + std::to_string(seed));
+    std::filesystem::path away = directory;
+    away += "-away";
+    std::filesystem::create_directories(directory);
+
+    bs::AlterSpillHeap<MyData> h(hot_capacity, directory);
+    // the same values, all in memory
+    bs::AlterBinaryHeap<MyData> expected;
+
+    // priorities which often tie, so that pops check the ids of the runs and the hot heap against each other
+    std::uniform_int_distribution priority_range(0, NUM_OF_COMMANDS_PER_VARIANT / 16);
+    std::uniform_int_distribution command_range(0, 9);
+    const auto random_id = [&] {
+        return expected.begin()[std::uniform_int_distribution<std::size_t>(0, expected.size() - 1)(rand)].id;
+    };
+
+    // it grows in the first half, so that the runs are merged over a few levels, then shrinks
+    for (idx = 0; idx < NUM_OF_COMMANDS_PER_VARIANT; ++idx)
+    {
+        const bool growing = idx < NUM_OF_COMMANDS_PER_VARIANT / 2;
+        if (idx == NUM_OF_COMMANDS_PER_VARIANT / 2)
+        {
+            // a push whose spill fails leaves the heap as it was, and can be retried
+            std::filesystem::rename(directory, away);
+            std::optional<MyData> failed;
+            for (int id = -1; !failed; --id)
+            {
+                const MyData value(priority_range(rand), id);
+                try
+                {
+                    h.push(value);
+                    expected.push(value);
+                }
+                catch (const std::runtime_error&)
+                {
+                    failed = value;
+                }
+                TEST_ASSERT(h.validate() && h.size() == expected.size(), "id=", id);
+                TEST_ASSERT(h.contains(id) == !failed, "id=", id);
+            }
+            std::filesystem::rename(away, directory);
+
+            h.push(*failed);
+            expected.push(*failed);
+            TEST_ASSERT(h.validate() && h.contains(failed->id) && h.hot_size() == 1);
+        }
+
+        const int command = command_range(rand);
+        if (command < (growing ? 2 : 4) && !h.empty())
+        {
+            // either may pop any of the tied values, so `expected` erases the one `h` pops
+            const MyData top = h.top();
+            TEST_ASSERT(top.priority == expected.top().priority);
+            TEST_ASSERT(expected.find(top.id)->priority == top.priority, "id=", top.id);
+            h.pop();
+            expected.erase(top.id);
+            TEST_ASSERT(!h.contains(top.id));
+        }
+        else if (command == (growing ? 2 : 4) && !h.empty())
+        {
+            const int id = random_id();
+            TEST_ASSERT(h.erase(id));
+            TEST_ASSERT(!h.erase(id));
+            expected.erase(id);
+        }
+        else
+        {
+            // overwrites the spilled values as well as the hot ones
+            const int id = (!h.empty() && rand() % 3 == 0) ? random_id() : idx;
+            TEST_ASSERT(h.contains(id) == (expected.find(id) != expected.cend()), "id=", id);
+            const MyData value(priority_range(rand), id);
+            h.push(value);
+            expected.push(value);
+        }
+
+        TEST_ASSERT(h.validate());
+        TEST_ASSERT(h.size() == expected.size());
+        // the tombstones not spilled yet share the hot capacity, but for the one of an overwrite
+        TEST_ASSERT(h.hot_size() + h.tombstone_count() <= std::max<std::size_t>(hot_capacity, 2));
+        TEST_ASSERT(h.run_count() <= bs::AlterSpillHeap<MyData>::MAX_RUNS);
+        TEST_ASSERT(h.empty() || h.top().priority == expected.top().priority);
+    }
+
+    // drains the runs
+    for (; !h.empty(); ++idx)
+    {
+        TEST_ASSERT(h.top().priority == expected.top().priority);
+        expected.erase(h.top().id);
+        h.pop();
+        TEST_ASSERT(h.validate());
+    }
+    // the pops skipped the values tombstoned in memory, or the merges dropped them
+    TEST_ASSERT(expected.empty() && h.run_count() == 0 && h.tombstone_count() == 0);
+    std::filesystem::remove_all(directory);
+
+    return true;
+}
+
+template <typename Heap>
+bool validate(unsigned seed, int idx, const Heap& h, const ReproduceInfo& repro)
 {
     TEST_ASSERT(h.validate(), repro);
+    TEST_ASSERT(h.empty() || std::none_of(h.begin(), h.end(), [&h](const MyData& val) { return h.top() < val; }),
+                repro);
+    if constexpr (DoubleEnded<Heap>)
+        TEST_ASSERT(h.empty() ||
+                        std::none_of(h.begin(), h.end(), [&h](const MyData& val) { return val < h.top_min(); }),
+                    repro);
+
+    using Layout = NodeLayout<Heap>;
+    const bs::MemoryUsage usage = h.memory_usage();
+    TEST_ASSERT(usage.node_count == h.size(), repro);
+    TEST_ASSERT(usage.node_bytes == h.size() * sizeof(Layout), repro);
+    TEST_ASSERT(usage.padding_bytes == h.size() * (sizeof(Layout) - Layout::MEMBER_BYTES), repro);
+    TEST_ASSERT(usage.bucket_bytes >= h.size() * Layout::MIN_BUCKET_BYTES, repro);
+    TEST_ASSERT(h.peak_memory_usage().total_bytes() >= usage.total_bytes(), repro);
     return true;
 }
@@ -10,6 +10,7 @@
 #include <sstream>
 #include <stdexcept>
 #include <thread>
+#include <utility>
 #include <vector>
 
 template <typename... Args>
@@ -36,6 +37,23 @@ void append_args(std::ostream& os, const Args&... args)
 
 static constexpr int NUM_OF_COMMANDS_PER_TEST = 100'000;
 
+// small, so that keys repeat
+static constexpr int MULTI_KEY_RANGE = 256;
+
+using MultiTree = bs::BSTree<int, int, std::less<int>, bs::MultiKeys>;
+
+// node layout of `BSTree<int, int>`, to check its memory accounting exactly: the links, then the payload
+struct NodeLayout
+{
+    static constexpr std::size_t MEMBER_BYTES = 3 * sizeof(void*) + 2 * sizeof(int);
+
+    void* parent;
+    void* left;
+    void* right;
+    int key;
+    int value;
+};
+
 enum class Command
 {
     INSERT,
@@ -89,7 +107,11 @@ std::ostream& operator<<(std::ostream& os, const ReproduceInfo& repro)
 }
 
 bool worker(unsigned seed);
-bool validate(unsigned seed, int idx, const bs::BSTree<int, int>&, const std::map<int, int>&, const ReproduceInfo&);
+bool validate(unsigned seed, int idx, const bs::BSTree<int, int>&, const bs::BSSet<int>&, const std::map<int, int>&,
+              const ReproduceInfo&);
+
+bool multi_worker(unsigned seed);
+bool validate_multi(unsigned seed, int idx, const MultiTree&, const std::multimap<int, int>&, const ReproduceInfo&);
 
 int main()
 {
@@ -105,16 +127,19 @@ int main()
     std::vector<std::future<bool>> futures;
     std::vector<bool> results;
 
-    futures.reserve(cores);
-    results.reserve(cores);
+    futures.reserve(cores * 2);
+    results.reserve(cores * 2);
 
     std::random_device rd;
 
     for (unsigned i = 0; i < cores; ++i)
+    {
         futures.push_back(std::async(std::launch::async, worker, rd()));
+        futures.push_back(std::async(std::launch::async, multi_worker, rd()));
+    }
 
-    for (unsigned i = 0; i < cores; ++i)
-        results.push_back(futures[i].get());
+    for (auto& future : futures)
+        results.push_back(future.get());
 
     if (!std::ranges::all_of(results, [](const bool val) { return val; }))
         return -1;
@@ -135,12 +160,14 @@ bool worker(unsigned seed)
     int idx = -1;
 
     bs::BSTree<int, int> t;
+    // same keys, without values
+    bs::BSSet<int> s;
     std::map<int, int> m;
 
     ReproduceInfo repro;
 
     TEST_ASSERT(t.empty() && m.empty());
-    if (!validate(seed, idx, t, m, repro))
+    if (!validate(seed, idx, t, s, m, repro))
         return false;
 
     std::mt19937 rand(seed);
@@ -156,12 +183,14 @@ bool worker(unsigned seed)
             const int num = all_int_range(rand);
             repro.commands.emplace_back(Command::INSERT, num);
             TEST_ASSERT(t.insert(num, num) == m.insert({num, num}).second, repro);
+            s.insert(num);
             break;
         }
         case Command::INSERT_OR_ASSIGN: {
             const int num = all_int_range(rand);
             repro.commands.emplace_back(Command::INSERT_OR_ASSIGN, num);
             TEST_ASSERT(t.insert_or_assign(num, num) == m.insert_or_assign(num, num).second, repro);
+            s.insert(num);
             break;
         }
         case Command::FIND_AND_ERASE:
@@ -181,31 +210,40 @@ bool worker(unsigned seed)
 
                 repro.commands.emplace_back(Command::FIND_AND_ERASE, key);
                 TEST_ASSERT(t.erase(key) == (bool)m.erase(key), repro);
+                TEST_ASSERT(s.find(key) && *s.find(key) == key && s.erase(key), repro);
             }
             break;
 
         default:
             throw std::logic_error(std::format("Invalid command kind={}", (int)command_kind));
         }
-        if (!validate(seed, idx, t, m, repro))
+        if (!validate(seed, idx, t, s, m, repro))
             return false;
     }
 
     t.clear();
+    s.clear();
     m.clear();
 
-    TEST_ASSERT(t.empty() && m.empty(), repro);
-    if (!validate(seed, idx, t, m, repro))
+    TEST_ASSERT(t.empty() && s.empty() && m.empty(), repro);
+    if (!validate(seed, idx, t, s, m, repro))
         return false;
 
     return true;
 }
 
-bool validate(unsigned seed, int idx, const bs::BSTree<int, int>& t, const std::map<int, int>& m,
-              const ReproduceInfo& repro)
+bool validate(unsigned seed, int idx, const bs::BSTree<int, int>& t, const bs::BSSet<int>& s,
+              const std::map<int, int>& m, const ReproduceInfo& repro)
 {
     TEST_ASSERT(t.empty() == m.empty(), repro);
     TEST_ASSERT(t.size() == m.size(), "\t", t.size(), " - ", m.size(), "\n", repro);
+    const bs::MemoryUsage usage = t.memory_usage();
+    TEST_ASSERT(usage.node_count == t.size(), repro);
+    TEST_ASSERT(usage.node_bytes == t.size() * sizeof(NodeLayout), repro);
+    TEST_ASSERT(usage.padding_bytes == t.size() * (sizeof(NodeLayout) - NodeLayout::MEMBER_BYTES), repro);
+    TEST_ASSERT(usage.overhead_bytes == t.size() * bs::allocation_overhead(sizeof(NodeLayout)) + sizeof(t), repro);
+    TEST_ASSERT(usage.bucket_bytes == 0 && usage.array_bytes == 0, repro);
+    TEST_ASSERT(t.peak_memory_usage().total_bytes() >= usage.total_bytes(), repro);
 
     std::vector<int> t_res, m_res;
     t_res.reserve(t.size());
@@ -219,5 +257,94 @@ bool validate(unsigned seed, int idx, const bs::BSTree<int, int>& t, const std::
         m_res.push_back(val);
 
     TEST_ASSERT(t_res == m_res, repro);
+
+    std::vector<int> s_res;
+    s_res.reserve(s.size());
+    s.inorder([&s_res](int key, [[maybe_unused]] const bs::TraversalInfo& info) { s_res.push_back(key); });
+
+    TEST_ASSERT(s_res == m_res, repro);
+    return true;
+}
+
+bool multi_worker(unsigned seed)
+{
+    // print current thread & seed info
+    {
+        std::ostringstream worker_info;
+        worker_info << "TID #" << std::this_thread::get_id() << ": seed=" << seed << " (multi)\n";
+        std::cout << worker_info.str();
+    }
+
+    int idx = -1;
+
+    MultiTree t;
+    std::multimap<int, int> m;
+
+    ReproduceInfo repro;
+
+    std::mt19937 rand(seed);
+    std::uniform_int_distribution key_range(0, MULTI_KEY_RANGE - 1);
+    // inserts twice as often as erases, so that equal keys pile up
+    std::uniform_int_distribution command_range(0, 2);
+
+    for (idx = 0; idx < NUM_OF_COMMANDS_PER_TEST; ++idx)
+    {
+        const int key = key_range(rand);
+        if (command_range(rand) != 0)
+        {
+            // `idx` as value, to check the insertion order of equal keys
+            repro.commands.emplace_back(Command::INSERT, key);
+            TEST_ASSERT(t.insert(key, idx), repro);
+            m.emplace(key, idx);
+            TEST_ASSERT(t.find(key) && *t.find(key) == m.lower_bound(key)->second, repro);
+        }
+        else
+        {
+            repro.commands.emplace_back(Command::FIND_AND_ERASE, key);
+            TEST_ASSERT(t.erase(key) == (bool)m.erase(key), repro);
+            TEST_ASSERT(!t.find(key) && t.count(key) == 0, repro);
+        }
+        if (!validate_multi(seed, idx, t, m, repro))
+            return false;
+    }
+
+    t.clear();
+    m.clear();
+
+    TEST_ASSERT(t.empty() && m.empty(), repro);
+    if (!validate_multi(seed, idx, t, m, repro))
+        return false;
+
+    return true;
+}
+
+bool validate_multi(unsigned seed, int idx, const MultiTree& t, const std::multimap<int, int>& m,
+                    const ReproduceInfo& repro)
+{
+    TEST_ASSERT(t.size() == m.size(), "\t", t.size(), " - ", m.size(), "\n", repro);
+
+    std::vector<std::pair<int, int>> t_res, m_res;
+    t_res.reserve(t.size());
+    t.inorder([&t_res](int key, int val, [[maybe_unused]] const bs::TraversalInfo& info) {
+        t_res.emplace_back(key, val);
+    });
+    m_res.assign(m.begin(), m.end());
+
+    TEST_ASSERT(t_res == m_res, repro);
+
+    for (auto iter = m.begin(); iter != m.end(); iter = m.upper_bound(iter->first))
+    {
+        const int key = iter->first;
+        TEST_ASSERT(t.find(key) && *t.find(key) == iter->second, "\tkey=", key, "\n", repro);
+        TEST_ASSERT(t.count(key) == m.count(key), "\tkey=", key, "\n", repro);
+
+        std::vector<int> t_vals, m_vals;
+        t.equal_range(key, [&t_vals](int, int val, const bs::TraversalInfo&) { t_vals.push_back(val); });
+        for (auto [first, last] = m.equal_range(key); first != last; ++first)
+            m_vals.push_back(first->second);
+
+        TEST_ASSERT(t_vals == m_vals, "\tkey=", key, "\n", repro);
+    }
+
     return true;
 }
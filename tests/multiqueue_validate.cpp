@@ -0,0 +1,316 @@
+#include "MultiQueue.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <format>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+template <typename... Args>
+void append_args(std::ostream& os, const Args&... args)
+{
+    if constexpr (sizeof...(args) > 0)
+        (os << ... << args);
+}
+
+#define TEST_ASSERT(condition, ...) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::ostringstream oss; \
+            oss << "Failed at seed=" << seed << ", idx=" << idx << ":\n"; \
+            oss << "\t" << #condition << "\n"; \
+            append_args(oss __VA_OPT__(, ) __VA_ARGS__); \
+            oss << "\n\n"; \
+            std::cerr << oss.str(); \
+            return false; \
+        } \
+    } while (false)
+
+static constexpr int NUM_OF_COMMANDS_PER_TEST = 200'000;
+
+// ids owned by each worker, which only it pushes, modifies and erases
+static constexpr int IDS_PER_WORKER = 4096;
+
+// workers sharing the queue, at least this many even on fewer cores, to exercise the locking
+static constexpr unsigned MIN_WORKERS = 4;
+
+struct MyData
+{
+    int priority;
+    int id;
+
+    int unique_id() const
+    {
+        return id;
+    }
+    bool operator<(const MyData& other) const
+    {
+        return priority < other.priority;
+    }
+};
+
+using Queue = bs::MultiQueue<MyData>;
+
+// can't be copied, so it's popped out of the shards by moving
+struct MoveOnlyData
+{
+    int priority;
+    int id;
+    std::unique_ptr<int> payload;
+
+    int unique_id() const
+    {
+        return id;
+    }
+    bool operator<(const MoveOnlyData& other) const
+    {
+        return priority < other.priority;
+    }
+};
+
+enum class Command
+{
+    PUSH,
+    MODIFY,
+    ERASE,
+
+    TOTAL_COUNT
+};
+
+/// @brief Priority of each id of a worker, `std::nullopt` if absent
+using Expected = std::vector<std::optional<int>>;
+
+bool strict_worker(unsigned seed);
+bool move_only_worker(unsigned seed);
+bool update_worker(unsigned seed, int worker_idx, Queue& queue, Expected& expected);
+bool pop_worker(Queue& queue, std::vector<MyData>& popped);
+bool check_updates(unsigned seed, const Queue& queue, const std::vector<Expected>& expected);
+bool check_pops(unsigned seed, const Queue& queue, const std::vector<Expected>& expected,
+                const std::vector<std::vector<MyData>>& popped);
+
+int main()
+{
+    unsigned cores = std::thread::hardware_concurrency();
+    if (cores)
+        std::cout << "system cores: " << cores << "\n";
+    else
+    {
+        cores = 8;
+        std::cout << "system cores detection failed, default to 8 cores\n";
+    }
+
+    const unsigned workers = std::max(cores, MIN_WORKERS);
+    std::random_device rd;
+
+    // a single shard is a strict priority queue
+    if (!strict_worker(rd()) || !move_only_worker(rd()))
+        return -1;
+
+    // every worker updates its own ids concurrently, then every worker pops until the queue is empty
+    const unsigned seed = rd();
+    std::cout << "concurrent: seed=" << seed << ", workers=" << workers << "\n";
+
+    Queue queue(workers);
+    std::vector<Expected> expected(workers, Expected(IDS_PER_WORKER));
+    std::vector<std::vector<MyData>> popped(workers);
+
+    std::vector<std::future<bool>> futures;
+    futures.reserve(workers);
+    for (unsigned i = 0; i < workers; ++i)
+        futures.push_back(
+            std::async(std::launch::async, update_worker, seed + i, (int)i, std::ref(queue), std::ref(expected[i])));
+    const bool updated = std::ranges::all_of(futures, [](auto& future) { return future.get(); });
+    if (!updated || !check_updates(seed, queue, expected))
+        return -1;
+
+    futures.clear();
+    for (unsigned i = 0; i < workers; ++i)
+        futures.push_back(std::async(std::launch::async, pop_worker, std::ref(queue), std::ref(popped[i])));
+    const bool drained = std::ranges::all_of(futures, [](auto& future) { return future.get(); });
+
+    if (!drained || !check_pops(seed, queue, expected, popped))
+        return -1;
+
+    std::cout << "Test succeeded!\n";
+    return 0;
+}
+
+bool strict_worker(unsigned seed)
+{
+    std::cout << "strict: seed=" << seed << "\n";
+
+    int idx = -1;
+
+    Queue queue(1, 1);
+    bs::AlterBinaryHeap<MyData> mirror;
+
+    std::mt19937 rand(seed);
+    std::uniform_int_distribution all_int_range;
+    std::uniform_int_distribution id_range(0, IDS_PER_WORKER - 1);
+    std::uniform_int_distribution command_range(0, 3);
+
+    for (idx = 0; idx < NUM_OF_COMMANDS_PER_TEST / 10; ++idx)
+    {
+        if (command_range(rand) == 0)
+        {
+            const auto value = queue.try_pop();
+            TEST_ASSERT(value.has_value() == !mirror.empty());
+            if (value)
+            {
+                TEST_ASSERT(value->priority == mirror.top().priority);
+                mirror.erase(value->id);
+            }
+        }
+        else
+        {
+            const MyData value{.priority = all_int_range(rand), .id = id_range(rand)};
+            queue.push(value);
+            mirror.push(value);
+        }
+        TEST_ASSERT(queue.size() == mirror.size());
+    }
+
+    TEST_ASSERT(queue.validate());
+    return true;
+}
+
+bool move_only_worker(unsigned seed)
+{
+    std::cout << "move-only: seed=" << seed << "\n";
+
+    int idx = -1;
+
+    bs::MultiQueue<MoveOnlyData> queue(1, 1);
+
+    std::mt19937 rand(seed);
+    std::uniform_int_distribution priority_range(0, IDS_PER_WORKER - 1);
+
+    for (idx = 0; idx < IDS_PER_WORKER; ++idx)
+        queue.push(MoveOnlyData{.priority = priority_range(rand), .id = idx, .payload = std::make_unique<int>(idx)});
+    TEST_ASSERT(queue.validate());
+
+    // a single shard pops in order, each value with its own payload
+    std::optional<int> last_priority;
+    for (idx = 0; auto value = queue.try_pop(); ++idx)
+    {
+        TEST_ASSERT(value->payload && *value->payload == value->id);
+        TEST_ASSERT(!last_priority || value->priority <= *last_priority);
+        last_priority = value->priority;
+    }
+    TEST_ASSERT(idx == IDS_PER_WORKER && queue.empty());
+
+    return true;
+}
+
+bool update_worker(unsigned seed, int worker_idx, Queue& queue, Expected& expected)
+{
+    int idx = -1;
+
+    std::mt19937 rand(seed);
+    std::uniform_int_distribution all_int_range;
+    std::uniform_int_distribution id_range(0, IDS_PER_WORKER - 1);
+    std::uniform_int_distribution command_range(0, (int)Command::TOTAL_COUNT - 1);
+
+    for (idx = 0; idx < NUM_OF_COMMANDS_PER_TEST; ++idx)
+    {
+        const int local_id = id_range(rand);
+        const int id = worker_idx * IDS_PER_WORKER + local_id;
+        std::optional<int>& priority = expected[local_id];
+
+        const auto command_kind = (Command)command_range(rand);
+        switch (command_kind)
+        {
+        case Command::PUSH: {
+            const int num = all_int_range(rand);
+            queue.push(MyData{.priority = num, .id = id});
+            priority = num;
+            break;
+        }
+        case Command::MODIFY: {
+            const int num = all_int_range(rand);
+            const bool found = queue.modify(id, [num](MyData& data) { data.priority = num; });
+            TEST_ASSERT(found == priority.has_value(), "modify(id=", id, ")");
+            if (found)
+                priority = num;
+            break;
+        }
+        case Command::ERASE: {
+            const bool erased = queue.erase(id);
+            TEST_ASSERT(erased == priority.has_value(), "erase(id=", id, ")");
+            priority.reset();
+            break;
+        }
+
+        default:
+            throw std::logic_error(std::format("Invalid command kind={}", (int)command_kind));
+        }
+
+        const auto found = queue.find(id);
+        TEST_ASSERT(found.has_value() == priority.has_value(), "find(id=", id, ")");
+        TEST_ASSERT(!found || found->priority == *priority, "find(id=", id, ")");
+    }
+
+    return true;
+}
+
+bool pop_worker(Queue& queue, std::vector<MyData>& popped)
+{
+    while (const auto value = queue.try_pop())
+        popped.push_back(*value);
+    return true;
+}
+
+bool check_updates(unsigned seed, const Queue& queue, const std::vector<Expected>& expected)
+{
+    const int idx = -1;
+
+    std::size_t count = 0;
+    for (const auto& priorities : expected)
+        for (const auto& priority : priorities)
+            count += priority.has_value();
+
+    TEST_ASSERT(queue.validate());
+    TEST_ASSERT(queue.size() == count);
+    return true;
+}
+
+bool check_pops(unsigned seed, const Queue& queue, const std::vector<Expected>& expected,
+                const std::vector<std::vector<MyData>>& popped)
+{
+    int idx = -1;
+
+    TEST_ASSERT(queue.empty());
+    TEST_ASSERT(queue.validate());
+
+    std::vector<std::optional<int>> popped_priority(expected.size() * IDS_PER_WORKER);
+    for (const auto& values : popped)
+    {
+        for (const auto& value : values)
+        {
+            idx = value.id;
+            TEST_ASSERT(value.id >= 0 && value.id < (int)popped_priority.size());
+            TEST_ASSERT(!popped_priority[value.id].has_value(), "popped twice");
+            popped_priority[value.id] = value.priority;
+        }
+    }
+
+    for (std::size_t worker_idx = 0; worker_idx < expected.size(); ++worker_idx)
+    {
+        for (int local_id = 0; local_id < IDS_PER_WORKER; ++local_id)
+        {
+            idx = (int)worker_idx * IDS_PER_WORKER + local_id;
+            TEST_ASSERT(popped_priority[idx] == expected[worker_idx][local_id]);
+        }
+    }
+
+    return true;
+}
@@ -5,11 +5,13 @@
 #include <format>
 #include <future>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <random>
 #include <sstream>
 #include <stdexcept>
 #include <thread>
+#include <utility>
 #include <vector>
 
 template <typename... Args>
@@ -36,6 +38,46 @@ void append_args(std::ostream& os, const Args&... args)
 
 static constexpr int NUM_OF_COMMANDS_PER_TEST = 100'000;
 
+// small, so that keys repeat
+static constexpr int MULTI_KEY_RANGE = 256;
+
+// commands between the full checks of the set, the equal ranges and the batched lookups,
+// on top of the tree checked after every command
+static constexpr int FULL_CHECK_INTERVAL = 256;
+
+/// @brief Whether to run the full checks after the command `idx`: periodically, and after the last one
+bool full_check_due(int idx)
+{
+    return idx >= NUM_OF_COMMANDS_PER_TEST - 1 || (idx >= 0 && idx % FULL_CHECK_INTERVAL == 0);
+}
+
+using MultiTree = bs::RBTree<int, int, std::less<int>, bs::MultiKeys>;
+
+// node layouts of `RBTree<int, int>` & `RBSet<int>`, to check their memory accounting exactly:
+// the links, the color, then the payload in the tail padding of the links
+struct MapNodeLayout
+{
+    static constexpr std::size_t MEMBER_BYTES = 3 * sizeof(void*) + sizeof(bool) + 2 * sizeof(int);
+
+    void* parent;
+    void* left;
+    void* right;
+    bool red;
+    int key;
+    int value;
+};
+
+struct SetNodeLayout
+{
+    static constexpr std::size_t MEMBER_BYTES = 3 * sizeof(void*) + sizeof(bool) + sizeof(int);
+
+    void* parent;
+    void* left;
+    void* right;
+    bool red;
+    int key;
+};
+
 enum class Command
 {
     INSERT,
@@ -88,8 +130,45 @@ std::ostream& operator<<(std::ostream& os, const ReproduceInfo& repro)
     return os;
 }
 
+// compile-time build, erase & lookup
+constexpr bool validate_constexpr()
+{
+    bs::RBTree<int, int> t;
+    for (int i = 0; i < 64; ++i)
+        t.insert((i * 37) % 64, i);
+    for (int i = 0; i < 64; i += 3)
+        t.erase(i);
+    t.insert_or_assign(1, -1);
+
+    if (!t.validate() || t.size() != 64 - 22)
+        return false;
+    if (t.find(0) || !t.find(1) || *t.find(1) != -1 || t.find(64))
+        return false;
+
+    int prev = -1;
+    bool ascending = true;
+    t.inorder([&](const int key, const int, const bs::TraversalInfo&) {
+        ascending = ascending && prev < key;
+        prev = key;
+    });
+    return ascending;
+}
+static_assert(validate_constexpr());
+
+constexpr auto SQUARES = [] {
+    bs::RBTree<int, int> t;
+    for (int i = 9; i >= 0; --i)
+        t.insert(i, i * i);
+    return t.to_flat_table<10>();
+}();
+static_assert(SQUARES.size() == 10 && *SQUARES.find(7) == 49 && !SQUARES.find(10));
+
 bool worker(unsigned seed);
-bool validate(unsigned seed, int idx, const bs::RBTree<int, int>&, const std::map<int, int>&, const ReproduceInfo&);
+bool validate(unsigned seed, int idx, const bs::RBTree<int, int>&, const bs::RBSet<int>&, const std::map<int, int>&,
+              const ReproduceInfo&);
+
+bool multi_worker(unsigned seed);
+bool validate_multi(unsigned seed, int idx, const MultiTree&, const std::multimap<int, int>&, const ReproduceInfo&);
 
 int main()
 {
@@ -105,16 +184,19 @@ int main()
     std::vector<std::future<bool>> futures;
     std::vector<bool> results;
 
-    futures.reserve(cores);
-    results.reserve(cores);
+    futures.reserve(cores * 2);
+    results.reserve(cores * 2);
 
     std::random_device rd;
 
     for (unsigned i = 0; i < cores; ++i)
+    {
         futures.push_back(std::async(std::launch::async, worker, rd()));
+        futures.push_back(std::async(std::launch::async, multi_worker, rd()));
+    }
 
-    for (unsigned i = 0; i < cores; ++i)
-        results.push_back(futures[i].get());
+    for (auto& future : futures)
+        results.push_back(future.get());
 
     if (!std::ranges::all_of(results, [](const bool val) { return val; }))
         return -1;
@@ -135,12 +217,14 @@ bool worker(unsigned seed)
     int idx = -1;
 
     bs::RBTree<int, int> t;
+    // same keys, without values
+    bs::RBSet<int> s;
     std::map<int, int> m;
 
     ReproduceInfo repro;
 
     TEST_ASSERT(t.empty() && m.empty());
-    if (!validate(seed, idx, t, m, repro))
+    if (!validate(seed, idx, t, s, m, repro))
         return false;
 
     std::mt19937 rand(seed);
@@ -156,12 +240,14 @@ bool worker(unsigned seed)
             const int num = all_int_range(rand);
             repro.commands.emplace_back(Command::INSERT, num);
             TEST_ASSERT(t.insert(num, num) == m.insert({num, num}).second, repro);
+            s.insert(num);
             break;
         }
         case Command::INSERT_OR_ASSIGN: {
             const int num = all_int_range(rand);
             repro.commands.emplace_back(Command::INSERT_OR_ASSIGN, num);
             TEST_ASSERT(t.insert_or_assign(num, num) == m.insert_or_assign(num, num).second, repro);
+            s.insert(num);
             break;
         }
         case Command::FIND_AND_ERASE:
@@ -180,34 +266,53 @@ bool worker(unsigned seed)
                 }
 
                 repro.commands.emplace_back(Command::FIND_AND_ERASE, key);
+                // twice, to hit the last found node
+                TEST_ASSERT(t.find(key) && *t.find(key) == m.at(key), repro);
                 TEST_ASSERT(t.erase(key) == (bool)m.erase(key), repro);
+                const int* const s_key = s.find(key);
+                TEST_ASSERT(s_key != nullptr, repro);
+                TEST_ASSERT(*s_key == key && s.erase(key), repro);
+                TEST_ASSERT(!t.find(key), repro);
             }
             break;
 
         default:
             throw std::logic_error(std::format("Invalid command kind={}", (int)command_kind));
         }
-        if (!validate(seed, idx, t, m, repro))
+        if (!validate(seed, idx, t, s, m, repro))
             return false;
     }
 
     t.clear();
+    s.clear();
     m.clear();
 
-    TEST_ASSERT(t.empty() && m.empty(), repro);
-    if (!validate(seed, idx, t, m, repro))
+    TEST_ASSERT(t.empty() && s.empty() && m.empty(), repro);
+    if (!validate(seed, idx, t, s, m, repro))
         return false;
 
     return true;
 }
 
-bool validate(unsigned seed, int idx, const bs::RBTree<int, int>& t, const std::map<int, int>& m,
-              const ReproduceInfo& repro)
+bool validate(unsigned seed, int idx, const bs::RBTree<int, int>& t, const bs::RBSet<int>& s,
+              const std::map<int, int>& m, const ReproduceInfo& repro)
 {
     TEST_ASSERT(t.empty() == m.empty(), repro);
     TEST_ASSERT(t.size() == m.size(), "\t", t.size(), " - ", m.size(), "\n", repro);
+    const bs::MemoryUsage usage = t.memory_usage();
+    TEST_ASSERT(usage.node_count == t.size(), repro);
+    TEST_ASSERT(usage.node_bytes == t.size() * sizeof(MapNodeLayout), repro);
+    TEST_ASSERT(usage.padding_bytes == t.size() * (sizeof(MapNodeLayout) - MapNodeLayout::MEMBER_BYTES), repro);
+    TEST_ASSERT(usage.overhead_bytes == t.size() * bs::allocation_overhead(sizeof(MapNodeLayout)) + sizeof(t), repro);
+    TEST_ASSERT(usage.bucket_bytes == 0 && usage.array_bytes == 0, repro);
+    TEST_ASSERT(t.peak_memory_usage().total_bytes() >= usage.total_bytes(), repro);
+
+    const bs::MemoryUsage set_usage = s.memory_usage();
+    TEST_ASSERT(set_usage.node_bytes == s.size() * sizeof(SetNodeLayout), repro);
+    TEST_ASSERT(set_usage.padding_bytes == s.size() * (sizeof(SetNodeLayout) - SetNodeLayout::MEMBER_BYTES), repro);
 
     TEST_ASSERT(t.validate());
+    TEST_ASSERT(s.size() == m.size(), repro);
 
     std::vector<int> t_res, m_res;
     t_res.reserve(t.size());
@@ -221,5 +326,159 @@ bool validate(unsigned seed, int idx, const bs::RBTree<int, int>& t, const std::
         m_res.push_back(val);
 
     TEST_ASSERT(t_res == m_res, repro);
+
+    if (!full_check_due(idx))
+        return true;
+
+    TEST_ASSERT(s.validate());
+    std::vector<int> s_res;
+    s_res.reserve(s.size());
+    s.inorder([&s_res](int key, [[maybe_unused]] const bs::TraversalInfo& info) { s_res.push_back(key); });
+
+    TEST_ASSERT(s_res == m_res, repro);
+
+    // batched lookups of present & (mostly) absent keys
+    std::vector<int> find_keys;
+    find_keys.reserve(m.size() * 2);
+    for (const auto& [key, val] : m)
+    {
+        find_keys.push_back(key);
+        find_keys.push_back(key ^ 1);
+    }
+
+    std::vector<const int*> found(find_keys.size());
+    t.find_many(find_keys, found);
+    for (std::size_t i = 0; i < find_keys.size(); ++i)
+        TEST_ASSERT(found[i] == t.find(find_keys[i]), "\tkey=", find_keys[i], "\n", repro);
+
+    // finger search over ascending, then descending keys
+    std::vector<int> sorted_keys;
+    sorted_keys.reserve(m.size() * 2);
+    for (const auto& [key, val] : m)
+    {
+        sorted_keys.push_back(key);
+        if (key != std::numeric_limits<int>::max())
+            sorted_keys.push_back(key + 1);
+    }
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        std::vector<const int*> sorted_found(sorted_keys.size());
+        t.find_sorted_batch(sorted_keys, sorted_found);
+        for (std::size_t i = 0; i < sorted_keys.size(); ++i)
+            TEST_ASSERT(sorted_found[i] == t.find(sorted_keys[i]), "\tkey=", sorted_keys[i], "\n", repro);
+
+        std::ranges::reverse(sorted_keys);
+    }
+
+    return true;
+}
+
+bool multi_worker(unsigned seed)
+{
+    // print current thread & seed info
+    {
+        std::ostringstream worker_info;
+        worker_info << "TID #" << std::this_thread::get_id() << ": seed=" << seed << " (multi)\n";
+        std::cout << worker_info.str();
+    }
+
+    int idx = -1;
+
+    MultiTree t;
+    std::multimap<int, int> m;
+
+    ReproduceInfo repro;
+
+    std::mt19937 rand(seed);
+    std::uniform_int_distribution key_range(0, MULTI_KEY_RANGE - 1);
+    // inserts twice as often as erases, so that equal keys pile up
+    std::uniform_int_distribution command_range(0, 2);
+
+    for (idx = 0; idx < NUM_OF_COMMANDS_PER_TEST; ++idx)
+    {
+        const int key = key_range(rand);
+        if (command_range(rand) != 0)
+        {
+            // `idx` as value, to check the insertion order of equal keys
+            repro.commands.emplace_back(Command::INSERT, key);
+            TEST_ASSERT(t.insert(key, idx), repro);
+            m.emplace(key, idx);
+            const int* const first_val = t.find(key);
+            TEST_ASSERT(first_val != nullptr, repro);
+            TEST_ASSERT(*first_val == m.lower_bound(key)->second, repro);
+        }
+        else
+        {
+            repro.commands.emplace_back(Command::FIND_AND_ERASE, key);
+            TEST_ASSERT(t.erase(key) == (bool)m.erase(key), repro);
+            TEST_ASSERT(!t.find(key) && t.count(key) == 0, repro);
+        }
+        if (!validate_multi(seed, idx, t, m, repro))
+            return false;
+    }
+
+    t.clear();
+    m.clear();
+
+    TEST_ASSERT(t.empty() && m.empty(), repro);
+    if (!validate_multi(seed, idx, t, m, repro))
+        return false;
+
+    return true;
+}
+
+bool validate_multi(unsigned seed, int idx, const MultiTree& t, const std::multimap<int, int>& m,
+                    const ReproduceInfo& repro)
+{
+    TEST_ASSERT(t.size() == m.size(), "\t", t.size(), " - ", m.size(), "\n", repro);
+    TEST_ASSERT(t.validate(), repro);
+
+    std::vector<std::pair<int, int>> t_res, m_res;
+    t_res.reserve(t.size());
+    t.inorder([&t_res](int key, int val, [[maybe_unused]] const bs::TraversalInfo& info) {
+        t_res.emplace_back(key, val);
+    });
+    m_res.assign(m.begin(), m.end());
+
+    TEST_ASSERT(t_res == m_res, repro);
+
+    if (!full_check_due(idx))
+        return true;
+
+    for (auto iter = m.begin(); iter != m.end(); iter = m.upper_bound(iter->first))
+    {
+        const int key = iter->first;
+        TEST_ASSERT(t.find(key) && *t.find(key) == iter->second, "\tkey=", key, "\n", repro);
+        TEST_ASSERT(t.count(key) == m.count(key), "\tkey=", key, "\n", repro);
+
+        std::vector<int> t_vals, m_vals;
+        t.equal_range(key, [&t_vals](int, int val, const bs::TraversalInfo&) { t_vals.push_back(val); });
+        for (auto [first, last] = m.equal_range(key); first != last; ++first)
+            m_vals.push_back(first->second);
+
+        TEST_ASSERT(t_vals == m_vals, "\tkey=", key, "\n", repro);
+    }
+
+    // batched lookups, ascending & descending
+    std::vector<int> find_keys(MULTI_KEY_RANGE);
+    for (int key = 0; key < MULTI_KEY_RANGE; ++key)
+        find_keys[key] = key;
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        std::vector<const int*> found(find_keys.size());
+        std::vector<const int*> sorted_found(find_keys.size());
+        t.find_many(find_keys, found);
+        t.find_sorted_batch(find_keys, sorted_found);
+        for (std::size_t i = 0; i < find_keys.size(); ++i)
+        {
+            TEST_ASSERT(found[i] == t.find(find_keys[i]), "\tkey=", find_keys[i], "\n", repro);
+            TEST_ASSERT(sorted_found[i] == t.find(find_keys[i]), "\tkey=", find_keys[i], "\n", repro);
+        }
+
+        std::ranges::reverse(find_keys);
+    }
+
     return true;
 }
@@ -0,0 +1,186 @@
+#include "TimerWheel.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+template <typename... Args>
+void append_args(std::ostream& os, const Args&... args)
+{
+    if constexpr (sizeof...(args) > 0)
+        (os << ... << args);
+}
+
+#define TEST_ASSERT(condition, ...) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::ostringstream oss; \
+            oss << "Failed at seed=" << seed << ", idx=" << idx << ":\n"; \
+            oss << "\t" << #condition << "\n"; \
+            append_args(oss __VA_OPT__(, ) __VA_ARGS__); \
+            oss << "\n\n"; \
+            std::cerr << oss.str(); \
+            return false; \
+        } \
+    } while (false)
+
+static constexpr int NUM_OF_COMMANDS_PER_TEST = 200'000;
+
+// few enough ids that they're often rescheduled and cancelled
+static constexpr int NUM_OF_IDS = 2048;
+
+using Wheel = bs::TimerWheel<int>;
+using Tick = Wheel::Tick;
+
+// ticks covered by the wheel, past which timers go to the heap
+static constexpr Tick WHEEL_REACH = Tick{1} << (Wheel::SLOT_BITS * Wheel::LEVELS);
+
+enum class Command
+{
+    SCHEDULE_NEAR,
+    SCHEDULE_WHEEL,
+    SCHEDULE_FAR,
+    CANCEL,
+    ADVANCE,
+
+    TOTAL_COUNT
+};
+
+bool worker(unsigned seed);
+
+int main()
+{
+    unsigned cores = std::thread::hardware_concurrency();
+    if (cores)
+        std::cout << "system cores: " << cores << "\n";
+    else
+    {
+        cores = 8;
+        std::cout << "system cores detection failed, default to 8 cores\n";
+    }
+
+    std::vector<std::future<bool>> futures;
+    futures.reserve(cores);
+
+    std::random_device rd;
+    for (unsigned i = 0; i < cores; ++i)
+        futures.push_back(std::async(std::launch::async, worker, rd()));
+
+    const bool succeeded = std::ranges::all_of(futures, [](auto& future) { return future.get(); });
+    if (!succeeded)
+        return -1;
+
+    std::cout << "Test succeeded!\n";
+    return 0;
+}
+
+bool worker(unsigned seed)
+{
+    // print current thread & seed info
+    {
+        std::ostringstream worker_info;
+        worker_info << "TID #" << std::this_thread::get_id() << ": seed=" << seed << "\n";
+        std::cout << worker_info.str();
+    }
+
+    int idx = -1;
+
+    Wheel wheel;
+    // deadline of each id, `std::nullopt` if it has no timer
+    std::vector<std::optional<Tick>> expected(NUM_OF_IDS);
+    std::size_t expected_size = 0;
+
+    std::mt19937_64 rand(seed);
+    std::uniform_int_distribution id_range(0, NUM_OF_IDS - 1);
+    std::uniform_int_distribution command_range(0, (int)Command::TOTAL_COUNT - 1);
+
+    for (idx = 0; idx < NUM_OF_COMMANDS_PER_TEST; ++idx)
+    {
+        const int id = id_range(rand);
+        const auto command_kind = (Command)command_range(rand);
+        switch (command_kind)
+        {
+        case Command::SCHEDULE_NEAR:
+        case Command::SCHEDULE_WHEEL:
+        case Command::SCHEDULE_FAR: {
+            // near ones may already be due, far ones go to the heap
+            const Tick now = wheel.now();
+            Tick deadline = 0;
+            if (command_kind == Command::SCHEDULE_NEAR)
+                deadline = std::uniform_int_distribution<Tick>(now > 8 ? now - 8 : 0, now + 256)(rand);
+            else if (command_kind == Command::SCHEDULE_WHEEL)
+                deadline = std::uniform_int_distribution<Tick>(now, now + WHEEL_REACH)(rand);
+            else
+                deadline = std::uniform_int_distribution<Tick>(now + WHEEL_REACH, now + WHEEL_REACH * 64)(rand);
+
+            wheel.schedule(id, deadline);
+            if (!expected[id])
+                expected_size += 1;
+            expected[id] = std::max(deadline, now + 1);
+            TEST_ASSERT(wheel.contains(id), "schedule(id=", id, ", deadline=", deadline, ")");
+            break;
+        }
+        case Command::CANCEL: {
+            TEST_ASSERT(wheel.cancel(id) == expected[id].has_value(), "cancel(id=", id, ")");
+            TEST_ASSERT(!wheel.cancel(id) && !wheel.contains(id), "cancel(id=", id, ")");
+            if (expected[id])
+                expected_size -= 1;
+            expected[id].reset();
+            break;
+        }
+        case Command::ADVANCE: {
+            // mostly small steps, sometimes across the levels, rarely over the whole wheel
+            const Tick now = wheel.now();
+            const int jump = (int)(rand() % 16);
+            const Tick step = (jump == 0)   ? std::uniform_int_distribution<Tick>(0, WHEEL_REACH * 4)(rand)
+                              : (jump <= 3) ? std::uniform_int_distribution<Tick>(0, WHEEL_REACH / 64)(rand)
+                                            : std::uniform_int_distribution<Tick>(0, 64)(rand);
+
+            std::vector<int> fired;
+            wheel.advance(now + step, std::back_inserter(fired));
+            TEST_ASSERT(wheel.now() == now + step);
+
+            std::vector<int> due;
+            for (int i = 0; i < NUM_OF_IDS; ++i)
+                if (expected[i] && *expected[i] <= now + step)
+                    due.push_back(i);
+            TEST_ASSERT(fired.size() == due.size(), "advance(now=", now + step, ")");
+
+            // in deadline order, each id once
+            for (std::size_t i = 0; i < fired.size(); ++i)
+            {
+                const int fired_id = fired[i];
+                TEST_ASSERT(expected[fired_id] && *expected[fired_id] <= now + step, "id=", fired_id);
+                TEST_ASSERT(i == 0 || *expected[fired[i - 1]] <= *expected[fired_id], "id=", fired_id);
+            }
+            for (const int fired_id : fired)
+            {
+                TEST_ASSERT(expected[fired_id].has_value(), "fired twice, id=", fired_id);
+                expected[fired_id].reset();
+                expected_size -= 1;
+                TEST_ASSERT(!wheel.contains(fired_id), "id=", fired_id);
+            }
+            break;
+        }
+
+        default:
+            throw std::logic_error("Invalid command kind");
+        }
+
+        TEST_ASSERT(wheel.validate());
+        TEST_ASSERT(wheel.size() == expected_size);
+    }
+
+    return true;
+}